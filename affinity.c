@@ -0,0 +1,115 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "affinity.h"
+#include <errno.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+
+static int cpu_list[CPU_SETSIZE];   // 可用 CPU 的編號，升序
+static int cpu_list_count;
+static int pin_workers;
+
+int affinity_configure(int reserve, int pin)
+{
+    cpu_set_t set;
+    cpu_list_count = 0;
+    pin_workers = 0;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set))
+                cpu_list[cpu_list_count++] = c;
+        }
+    }
+    if (cpu_list_count == 0) {
+        // 取不到進程的 CPU 集合時退回在線 CPU 數，此時無法綁核
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        int count = n > 0 ? (int)n : 1;
+        if (reserve >= count) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (pin) {
+            errno = ENOSYS;
+            return -1;
+        }
+        return count - reserve;
+    }
+
+    if (reserve >= cpu_list_count) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (reserve > 0) {
+        // 之後創建的所有線程（包括讀取、寫出線程）都繼承這個集合
+        for (int i = cpu_list_count - reserve; i < cpu_list_count; i++)
+            CPU_CLR(cpu_list[i], &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+            return -1;
+        cpu_list_count -= reserve;
+    }
+    pin_workers = pin;
+    return cpu_list_count;
+}
+
+int affinity_pin_worker(int index)
+{
+    if (!pin_workers)
+        return 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_list[index % cpu_list_count], &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+int affinity_configure(int reserve, int pin)
+{
+    int count = 4;
+#ifdef _WIN32
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    count = (int)sysinfo.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0)
+        count = (int)n;
+#endif
+    if (count < 1)
+        count = 1;
+    if (reserve >= count) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (pin) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return count - reserve;
+}
+
+int affinity_pin_worker(int index)
+{
+    (void)index;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,29 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 工作線程的 CPU 放置計劃（進程內唯一，在創建任何工作線程之前由主線程設置一次）
+//
+// 以進程當前允許運行的 CPU 集合（taskset/cgroup 限制後的結果）為準，去掉編號最大的 reserve 個 CPU
+// 留給同機的其他服務，並把整個進程限制在餘下的 CPU 上。pin 非 0 時，其後每個工作線程調用
+// affinity_pin_worker 綁定到餘下 CPU 中的第 index 個（按編號排列，超出時循環）。
+// 返回餘下的 CPU 數（至少 1）；-1 表示失敗（保留數不小於可用 CPU 數時 errno 為 EINVAL，
+// 平台不支持綁核時為 ENOSYS）。
+int affinity_configure(int reserve, int pin);
+
+// 在工作線程開頭調用。未啟用綁核時什麼也不做。
+// 綁定後線程自己分配並首次寫入的內存按 Linux 的首次訪問策略落在該 CPU 所在的 NUMA 節點上。
+// 返回 0 表示成功或無需綁定，-1 表示失敗（errno 保存原因）。
+int affinity_pin_worker(int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AFFINITY_H
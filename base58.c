@@ -13,6 +13,26 @@
 /* Bitcoin 使用的 Base58 字母表 */
 static const char *BASE58_ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
+/* 反向查找表：字符 → 字母表下標，非法字符為 -1 */
+static const int8_t BASE58_MAP[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8,-1,-1,-1,-1,-1,-1,
+    -1, 9,10,11,12,13,14,15,16,-1,17,18,19,20,21,-1,
+    22,23,24,25,26,27,28,29,30,31,32,-1,-1,-1,-1,-1,
+    -1,33,34,35,36,37,38,39,40,41,42,43,-1,44,45,46,
+    47,48,49,50,51,52,53,54,55,56,57,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
 /*
  * 内部函數：base58_encode
  */
@@ -87,12 +107,11 @@ static uint8_t *base58_decode(const char *b58, size_t *result_len) {
         return NULL;
 
     for (size_t i = 0; i < b58_len; i++) {
-        const char *p = strchr(BASE58_ALPHABET, b58[i]);
-        if (!p) {
+        int digit = BASE58_MAP[(unsigned char)b58[i]];
+        if (digit < 0) {
             free(bin);
             return NULL;  /* 出現非法字符 */
         }
-        int digit = p - BASE58_ALPHABET;
         int carry = digit;
         for (int j = (int)size - 1; j >= 0; j--) {
             carry += 58 * bin[j];
@@ -131,15 +150,8 @@ static uint8_t *base58_decode(const char *b58, size_t *result_len) {
  * 然後將數據與校驗和拼接後進行 Base58 編碼。
  */
 char *base58_encode_check(const uint8_t *data, size_t data_len) {
-    uint8_t hash1[SHA256_BLOCK_SIZE], hash2[SHA256_BLOCK_SIZE];
-    SHA256_CTX ctx;
-    sha256_init(&ctx);
-    sha256_update(&ctx, data, data_len);
-    sha256_final(&ctx, hash1);
-
-    sha256_init(&ctx);
-    sha256_update(&ctx, hash1, SHA256_BLOCK_SIZE);
-    sha256_final(&ctx, hash2);
+    uint8_t hash2[SHA256_BLOCK_SIZE];
+    sha256d_short(data, data_len, hash2);
 
     size_t new_len = data_len + 4;
     uint8_t *buffer = (uint8_t *)malloc(new_len);
@@ -174,15 +186,8 @@ uint8_t *base58_decode_check(const char *b58, size_t *result_len) {
     }
     memcpy(payload, bin, payload_len);
 
-    uint8_t hash1[SHA256_BLOCK_SIZE], hash2[SHA256_BLOCK_SIZE];
-    SHA256_CTX ctx;
-    sha256_init(&ctx);
-    sha256_update(&ctx, payload, payload_len);
-    sha256_final(&ctx, hash1);
-
-    sha256_init(&ctx);
-    sha256_update(&ctx, hash1, SHA256_BLOCK_SIZE);
-    sha256_final(&ctx, hash2);
+    uint8_t hash2[SHA256_BLOCK_SIZE];
+    sha256d_short(payload, payload_len, hash2);
 
     if (memcmp(hash2, bin + payload_len, 4) != 0) {
         free(bin);
@@ -195,6 +200,177 @@ uint8_t *base58_decode_check(const char *b58, size_t *result_len) {
     return payload;
 }
 
+/*
+ * 以 32 位字（limb）為單位的 Base58 解碼。
+ * 每次把 5 個 Base58 數字合成一個不超過 58^5 < 2^32 的值，再一次乘加進大數，
+ * 相比逐字節乘 58 的寫法，乘法次數約減少為 1/20。
+ */
+static const uint32_t BASE58_POW[6] = {1, 58, 3364, 195112, 11316496, 656356768};
+
+/* 7 個 limb = 28 字節，足以容納 25 字節（版本 + hash160 + 校驗和）和 26 字節（雙字節版本）的地址；
+ * 38 個有效數字的最大值 58^38 - 1 < 2^224，一定不會溢出 */
+#define B58_SMALL_LIMBS 7
+#define B58_SMALL_DIGITS 38
+/* 通用路徑最多解碼 512 字節 */
+#define B58_MAX_LIMBS 128
+
+/* 讀取最多 5 個數字，返回它們組成的值，非法字符返回 -1 */
+static inline int64_t b58_digit_group(const char *b58, size_t k) {
+    uint32_t acc = 0;
+    for (size_t n = 0; n < k; n++) {
+        int digit = BASE58_MAP[(unsigned char)b58[n]];
+        if (digit < 0)
+            return -1;
+        acc = acc * 58 + (uint32_t)digit;
+    }
+    return acc;
+}
+
+/* 固定長度快速路徑：limb 數為編譯期常數，內層循環可被完全展開 */
+static int b58_decode_small(const char *b58, size_t len, uint32_t limbs[B58_SMALL_LIMBS]) {
+    for (int j = 0; j < B58_SMALL_LIMBS; j++)
+        limbs[j] = 0;
+    for (size_t i = 0; i < len; ) {
+        size_t k = len - i < 5 ? len - i : 5;
+        int64_t group = b58_digit_group(b58 + i, k);
+        if (group < 0)
+            return 0;
+        i += k;
+        uint64_t mul = BASE58_POW[k];
+        uint64_t t = (uint64_t)group;
+        for (int j = 0; j < B58_SMALL_LIMBS; j++) {
+            t += limbs[j] * mul;
+            limbs[j] = (uint32_t)t;
+            t >>= 32;
+        }
+    }
+    return 1;
+}
+
+/* 通用路徑：只對已使用的 limb 做乘加，超出 nlimbs 視為溢出 */
+static int b58_decode_limbs(const char *b58, size_t len, uint32_t *limbs, size_t nlimbs) {
+    size_t used = 0;
+    for (size_t i = 0; i < len; ) {
+        size_t k = len - i < 5 ? len - i : 5;
+        int64_t group = b58_digit_group(b58 + i, k);
+        if (group < 0)
+            return 0;
+        i += k;
+        uint64_t mul = BASE58_POW[k];
+        uint64_t t = (uint64_t)group;
+        for (size_t j = 0; j < used; j++) {
+            t += limbs[j] * mul;
+            limbs[j] = (uint32_t)t;
+            t >>= 32;
+        }
+        while (t != 0) {
+            if (used == nlimbs)
+                return 0;  /* 溢出 */
+            limbs[used++] = (uint32_t)t;
+            t >>= 32;
+        }
+    }
+    for (size_t j = used; j < nlimbs; j++)
+        limbs[j] = 0;
+    return 1;
+}
+
+/*
+ * 内部函數：無堆分配的 Base58 解碼，結果（前導 0x00 + 大數的大端字節）寫入 bin
+ */
+static int base58_decode_fast(const char *b58, size_t b58len, uint8_t *bin, size_t *binlen) {
+    while (b58len > 0 && *b58 == ' ') {
+        b58++;
+        b58len--;
+    }
+
+    /* 前導 '1' 對應原數據中的 0x00，不參與大數運算 */
+    size_t zeros = 0;
+    while (zeros < b58len && b58[zeros] == BASE58_ALPHABET[0])
+        zeros++;
+
+    uint32_t limbs[B58_MAX_LIMBS];
+    size_t nlimbs;
+    if (b58len - zeros <= B58_SMALL_DIGITS) {
+        nlimbs = B58_SMALL_LIMBS;
+        if (!b58_decode_small(b58 + zeros, b58len - zeros, limbs))
+            return 0;
+    } else {
+        nlimbs = ((b58len - zeros) * 733 / 1000 + 1 + 3) / 4;
+        if (nlimbs > B58_MAX_LIMBS)
+            return 0;
+        if (!b58_decode_limbs(b58 + zeros, b58len - zeros, limbs, nlimbs))
+            return 0;
+    }
+
+    /* 跳過大數的前導零字節 */
+    size_t top = nlimbs;
+    while (top > 0 && limbs[top - 1] == 0)
+        top--;
+    size_t nbytes = top * 4;
+    if (top > 0) {
+        uint32_t hi = limbs[top - 1];
+        while ((hi >> 24) == 0) {
+            hi <<= 8;
+            nbytes--;
+        }
+    }
+
+    size_t decoded_size = zeros + nbytes;
+    if (decoded_size > *binlen)
+        return 0;
+    memset(bin, 0, zeros);
+    uint8_t *p = bin + decoded_size;
+    for (size_t j = 0; j < nbytes; j++) {
+        *--p = (uint8_t)(limbs[j / 4] >> (8 * (j % 4)));
+    }
+    *binlen = decoded_size;
+    return 1;
+}
+
+/*
+ * 無堆分配的 Base58Check 解碼：
+ * 解碼到調用者的緩衝區後，對 payload 做雙 SHA-256 並比較 4 字節校驗和。
+ */
+int b58check_tobin(uint8_t *payload, size_t *payload_len, const char *b58, size_t b58len) {
+    size_t decoded_size = *payload_len;
+    if (!base58_decode_fast(b58, b58len, payload, &decoded_size))
+        return 0;
+    if (decoded_size < 4)
+        return 0;
+
+    size_t len = decoded_size - 4;
+    uint8_t hash2[SHA256_BLOCK_SIZE];
+    sha256d_short(payload, len, hash2);
+    if (memcmp(hash2, payload + len, 4) != 0)
+        return 0;  /* 校驗和不匹配 */
+
+    *payload_len = len;
+    return 1;
+}
+
+/*
+ * 批量 Base58Check 校驗：把多條 payload 的雙 SHA-256 交給多緩衝區實現一起計算
+ */
+void b58check_verify_batch(const uint8_t *const bins[], const size_t binlens[], size_t n, uint8_t ok[]) {
+    enum { BATCH = 16 };
+    for (size_t base = 0; base < n; base += BATCH) {
+        size_t count = n - base < BATCH ? n - base : BATCH;
+        const uint8_t *msgs[BATCH];
+        size_t lens[BATCH];
+        uint8_t digests[BATCH][SHA256_BLOCK_SIZE];
+        for (size_t i = 0; i < count; i++) {
+            msgs[i] = bins[base + i];
+            lens[i] = binlens[base + i] >= 4 ? binlens[base + i] - 4 : 0;
+        }
+        sha256d_short_batch(msgs, lens, count, digests);
+        for (size_t i = 0; i < count; i++) {
+            ok[base + i] = binlens[base + i] >= 4 &&
+                           memcmp(digests[i], bins[base + i] + lens[i], 4) == 0;
+        }
+    }
+}
+
 /*
  * 以下為對外接口的封裝函數：
  */
@@ -217,6 +393,13 @@ int b58enc(char *b58, size_t *b58len, const uint8_t *bin, size_t binlen) {
     return 1;
 }
 
+/*
+ * b58tobin_fast - 封裝 base58_decode_fast
+ */
+int b58tobin_fast(uint8_t *bin, size_t *binlen, const char *b58, size_t b58len) {
+    return base58_decode_fast(b58, b58len, bin, binlen);
+}
+
 /*
  * b58tobin - 封裝 base58_decode
  */
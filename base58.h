@@ -18,12 +18,26 @@ int b58enc(char *b58, size_t *b58len, const uint8_t *bin, size_t binlen);
 // 返回 1 表示成功，0 表示失敗。
 int b58tobin(uint8_t *bin, size_t *binlen, const char *b58, size_t b58len);
 
+// 與 b58tobin 相同的接口，但以 32 位字為單位、每次乘入 5 個數字，且不做任何堆分配。
+// 25/26 字節的地址 payload 走固定長度的快速路徑；最多解碼 512 字節。
+int b58tobin_fast(uint8_t *bin, size_t *binlen, const char *b58, size_t b58len);
+
 // Base58Check 編碼：對輸入數據先做雙 SHA-256，取前 4 字節作為校驗和，再將數據+校驗和進行 Base58 編碼
 char *base58_encode_check(const uint8_t *data, size_t data_len);
 
 // Base58Check 解碼：解碼後檢查校驗和正確性，若正確返回 payload（去除 4 字節校驗碼），否則返回 NULL
 uint8_t *base58_decode_check(const char *b58, size_t *result_len);
 
+// 無堆分配的 Base58Check 解碼：結果直接寫入調用者提供的緩衝區（通常位於棧上）
+// payload: 輸出緩衝區，需容納解碼後的 payload + 4 字節校驗和
+// payload_len: 輸入時表示緩衝區大小，輸出時返回 payload 長度（不含 4 字節校驗和）
+// 返回 1 表示成功，0 表示非法字符、緩衝區不足或校驗和不匹配。
+int b58check_tobin(uint8_t *payload, size_t *payload_len, const char *b58, size_t b58len);
+
+// 批量 Base58Check 校驗：bins[i] 為 b58tobin_fast 解碼出的完整數據（payload + 4 字節校驗和），
+// binlens[i] 為其長度；ok[i] 輸出 1 表示校驗和正確。payload 不超過 55 字節時雙 SHA-256 按 8/16 路並行計算。
+void b58check_verify_batch(const uint8_t *const bins[], const size_t binlens[], size_t n, uint8_t ok[]);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,78 +8,59 @@
 #include <ctype.h>
 
 #include "bech32.h"
+#include "polymod.h"
 /* Bech32 字符集 */
 static const char *CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
 
-/* --- 内部函数 --- */
+/* 字符集反查表：ASCII 字符 -> 5 位值，大小写均可，-1 表示不在字符集中 */
+static const int8_t CHARSET_REV[128] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+    -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+     1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
+    -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+     1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
+};
 
-/* 计算 Bech32 校验和（polymod） */
-static uint32_t bech32_polymod(const int *values, size_t values_len) {
-    uint32_t chk = 1;
-    for (size_t i = 0; i < values_len; i++) {
-        int top = chk >> 25;
-        chk = ((chk & 0x1ffffff) << 5) ^ (uint32_t)values[i];
-        for (int j = 0; j < 5; j++) {
-            if ((top >> j) & 1) {
-                switch(j) {
-                    case 0: chk ^= 0x3b6a57b2; break;
-                    case 1: chk ^= 0x26508e6d; break;
-                    case 2: chk ^= 0x1ea119fa; break;
-                    case 3: chk ^= 0x3d4233dd; break;
-                    case 4: chk ^= 0x2a1462b3; break;
-                }
-            }
-        }
-    }
-    return chk;
-}
+/* 校验和常量：Bech32（BIP-173）用于 witness v0，Bech32m（BIP-350）用于 witness v1～v16 */
+#define BECH32_CONST  1u
+#define BECH32M_CONST 0x2bc830a3u
 
-/* 将 HRP 扩展为校验和计算用的数组 */
-static int bech32_hrp_expand(const char *hrp, int *output) {
-    size_t hrp_len = strlen(hrp);
+/* --- 内部函数 --- */
+
+/* 将 HRP 扩展为校验和计算用的数组（高 3 位、0、低 5 位），返回值个数 */
+static size_t bech32_hrp_expand(const char *hrp, size_t hrp_len, uint8_t *output) {
     for (size_t i = 0; i < hrp_len; i++) {
-        output[i] = hrp[i] >> 5;
+        output[i] = (uint8_t)(hrp[i] >> 5);
     }
     output[hrp_len] = 0;
     for (size_t i = 0; i < hrp_len; i++) {
-        output[hrp_len + 1 + i] = hrp[i] & 31;
+        output[hrp_len + 1 + i] = (uint8_t)(hrp[i] & 31);
     }
-    return (int)(2 * hrp_len + 1);
+    return 2 * hrp_len + 1;
 }
 
-/* 校验 checksum 是否正确 */
-static int bech32_verify_checksum(const char *hrp, const int *data, size_t data_len) {
-    int hrp_expanded[256];
-    int hrp_exp_len = bech32_hrp_expand(hrp, hrp_expanded);
-    int values[256];
-    size_t total_len = hrp_exp_len + data_len;
-    if (total_len > 256) return 0;
-    memcpy(values, hrp_expanded, hrp_exp_len * sizeof(int));
-    memcpy(values + hrp_exp_len, data, data_len * sizeof(int));
-    return (bech32_polymod(values, total_len) == 1);
-}
-
-/* 根据 HRP 与数据生成 6 个校验值 */
-static void bech32_create_checksum(const char *hrp, const int *data, size_t data_len, int *checksum) {
-    int hrp_expanded[256];
-    int hrp_exp_len = bech32_hrp_expand(hrp, hrp_expanded);
-    int values[256];
-    size_t total_len = hrp_exp_len + data_len + 6;
-    memcpy(values, hrp_expanded, hrp_exp_len * sizeof(int));
-    memcpy(values + hrp_exp_len, data, data_len * sizeof(int));
-    for (int i = 0; i < 6; i++) {
-        values[hrp_exp_len + data_len + i] = 0;
-    }
-    uint32_t polymod = bech32_polymod(values, total_len) ^ 1;
+/* 根据 HRP 与数据生成 6 个校验值，enc_const 为 BECH32_CONST 或 BECH32M_CONST */
+static int bech32_create_checksum(const char *hrp, const uint8_t *data, size_t data_len, uint32_t enc_const, uint8_t *checksum) {
+    uint8_t values[2 * BECH32_HRP_MAX + 1 + 128];
+    size_t hrp_len = strlen(hrp);
+    if (hrp_len > BECH32_HRP_MAX || data_len + 6 > 128) return 0;
+    size_t n = bech32_hrp_expand(hrp, hrp_len, values);
+    memcpy(values + n, data, data_len);
+    memset(values + n + data_len, 0, 6);
+    uint32_t polymod = bech32_polymod(values, n + data_len + 6) ^ enc_const;
     for (int i = 0; i < 6; i++) {
         checksum[i] = (polymod >> (5 * (5 - i))) & 31;
     }
+    return 1;
 }
 
 /* 根据 HRP 与数据生成 Bech32 字符串 */
-static char *bech32_encode(const char *hrp, const int *data, size_t data_len) {
-    int checksum[6];
-    bech32_create_checksum(hrp, data, data_len, checksum);
+static char *bech32_encode(const char *hrp, const uint8_t *data, size_t data_len, uint32_t enc_const) {
+    uint8_t checksum[6];
+    if (!bech32_create_checksum(hrp, data, data_len, enc_const, checksum)) return NULL;
     size_t hrp_len = strlen(hrp);
     size_t output_len = hrp_len + 1 + data_len + 6;  /* hrp + '1' + 数据 + 校验值 */
     char *ret = malloc(output_len + 1);
@@ -87,8 +68,8 @@ static char *bech32_encode(const char *hrp, const int *data, size_t data_len) {
     strcpy(ret, hrp);
     ret[hrp_len] = '1';
     for (size_t i = 0; i < data_len; i++) {
-        int d = data[i];
-        if (d < 0 || d >= 32) { free(ret); return NULL; }
+        uint8_t d = data[i];
+        if (d >= 32) { free(ret); return NULL; }
         ret[hrp_len + 1 + i] = CHARSET[d];
     }
     for (size_t i = 0; i < 6; i++) {
@@ -98,50 +79,39 @@ static char *bech32_encode(const char *hrp, const int *data, size_t data_len) {
     return ret;
 }
 
-/* 解码 Bech32 字符串。
- * out_hrp: 保存 HRP 的缓冲区（至少 84 字节）。
- * out_data: 保存解码后数据的数组（调用者保证空间足够）。
- * out_data_len: 输出数据的个数（不含校验值）。
+/* 单遍解析 Bech32 字符串：查表得到 5 位值，与 HRP 扩展一起写入 parsed->values，不分配内存，不计算校验和。
  * 返回 1 表示成功，0 表示失败。
  */
-static int bech32_decode_impl(const char *bech, char *out_hrp, int *out_data, size_t *out_data_len) {
-    size_t len = strlen(bech);
+int bech32_parse(const char *bech, size_t len, Bech32Parsed *parsed) {
     if (len < 8 || len > 90) return 0;
     int has_lower = 0, has_upper = 0;
+    size_t pos = 0;
+    int found = 0;
     for (size_t i = 0; i < len; i++) {
         unsigned char c = bech[i];
         if (c < 33 || c > 126) return 0;
         if (c >= 'a' && c <= 'z') has_lower = 1;
         if (c >= 'A' && c <= 'Z') has_upper = 1;
+        if (c == '1') { pos = i; found = 1; }
     }
     if (has_lower && has_upper) return 0;  /* 不允许混合大小写 */
-    char *bech_copy = malloc(len + 1);
-    if (!bech_copy) return 0;
-    for (size_t i = 0; i < len; i++) {
-        bech_copy[i] = tolower(bech[i]);
-    }
-    bech_copy[len] = '\0';
-    int pos = -1;
-    for (size_t i = 0; i < len; i++) {
-        if (bech_copy[i] == '1') pos = i;
-    }
-    if (pos < 1 || pos + 7 > (int)len) { free(bech_copy); return 0; }
+    if (!found || pos < 1 || pos + 7 > len) return 0;
+
     size_t hrp_len = pos;
-    memcpy(out_hrp, bech_copy, hrp_len);
-    out_hrp[hrp_len] = '\0';
+    for (size_t i = 0; i < hrp_len; i++) {
+        parsed->hrp[i] = (char)tolower((unsigned char)bech[i]);
+    }
+    parsed->hrp[hrp_len] = '\0';
+    parsed->hrp_len = hrp_len;
+
+    size_t n = bech32_hrp_expand(parsed->hrp, hrp_len, parsed->values);
     size_t data_part_len = len - pos - 1;
-    if (data_part_len < 6) { free(bech_copy); return 0; }
     for (size_t i = 0; i < data_part_len; i++) {
-        char *p = strchr(CHARSET, bech_copy[pos + 1 + i]);
-        if (!p) { free(bech_copy); return 0; }
-        out_data[i] = p - CHARSET;
+        int8_t v = CHARSET_REV[(unsigned char)bech[pos + 1 + i]];
+        if (v < 0) return 0;
+        parsed->values[n + i] = (uint8_t)v;
     }
-    free(bech_copy);
-    if (!bech32_verify_checksum(out_hrp, out_data, data_part_len)) {
-        return 0;
-    }
-    if (data_part_len < 6) return 0;
-    *out_data_len = data_part_len - 6;
+    parsed->values_len = n + data_part_len;
     return 1;
 }
 
@@ -150,15 +120,15 @@ static int bech32_decode_impl(const char *bech, char *out_hrp, int *out_data, si
  * out 数组由调用者提供，outlen 输出转换后数组的长度。
  * 成功返回 1，失败返回 0。
  */
-static int convertbits(const int *in, size_t inlen, int frombits, int tobits, int pad, int *out, size_t *outlen) {
+static int convertbits(const uint8_t *in, size_t inlen, int frombits, int tobits, int pad, uint8_t *out, size_t *outlen) {
     uint32_t acc = 0;
     int bits = 0;
     size_t out_idx = 0;
     uint32_t maxv = (1 << tobits) - 1;
     uint32_t max_acc = (1 << (frombits + tobits - 1)) - 1;
     for (size_t i = 0; i < inlen; i++) {
-        int value = in[i];
-        if (value < 0 || (value >> frombits)) return 0;
+        uint32_t value = in[i];
+        if (value >> frombits) return 0;
         acc = ((acc << frombits) | value) & max_acc;
         bits += frombits;
         while (bits >= tobits) {
@@ -178,36 +148,42 @@ static int convertbits(const int *in, size_t inlen, int frombits, int tobits, in
     return 1;
 }
 
-/* 内部实现：解码 segwit 地址
- * addr: 输入的 Bech32 地址
- * hrp: 预期的 HRP
- * witver: 输出 witness 版本
- * witprog: 输出 witness 程序缓冲区（调用者保证空间足够）
- * witprog_len: 输入时为缓冲区大小，输出时为实际长度
+/* segwit_addr_decode_parsed: 由解析结果和其 polymod 值完成 segwit 解码
+ * 校验和常量必须与 witness 版本相符（BIP-350）。
  * 成功返回 1，失败返回 0。
  */
-static int segwit_addr_decode_internal(const char *addr, const char *hrp, int *witver, uint8_t *witprog, size_t *witprog_len) {
-    char hrp_decoded[84];
-    int data[90];
-    size_t data_len;
-    if (!bech32_decode_impl(addr, hrp_decoded, data, &data_len)) return 0;
-    if (strcmp(hrp_decoded, hrp) != 0) return 0;
+int segwit_addr_decode_parsed(const Bech32Parsed *parsed, uint32_t polymod, int *witver, uint8_t *witprog, size_t *witprog_len) {
+    if (polymod != BECH32_CONST && polymod != BECH32M_CONST) return 0;
+    const uint8_t *data = parsed->values + 2 * parsed->hrp_len + 1;
+    size_t data_len = parsed->values_len - (2 * parsed->hrp_len + 1) - 6;
     if (data_len < 1) return 0;
     *witver = data[0];
-    int conv[200];
+    /* BIP-350：v0 必须使用 Bech32，v1 及以上必须使用 Bech32m */
+    if (polymod != (*witver == 0 ? BECH32_CONST : BECH32M_CONST)) return 0;
+    uint8_t conv[64];
     size_t conv_len;
     if (!convertbits(data + 1, data_len - 1, 5, 8, 0, conv, &conv_len)) return 0;
     if (conv_len < 2 || conv_len > 40) return 0;
     if (*witver > 16) return 0;
     if (*witver == 0 && conv_len != 20 && conv_len != 32) return 0;
     if (*witprog_len < conv_len) return 0;
-    for (size_t i = 0; i < conv_len; i++) {
-        witprog[i] = (uint8_t)conv[i];
-    }
+    memcpy(witprog, conv, conv_len);
     *witprog_len = conv_len;
     return 1;
 }
 
+/* 内部实现：解码 segwit 地址，HRP 不做限制
+ * 成功返回 1，失败返回 0。
+ */
+static int segwit_addr_decode_internal(const char *addr, size_t len, char *hrp, int *witver, uint8_t *witprog, size_t *witprog_len) {
+    Bech32Parsed parsed;
+    if (!bech32_parse(addr, len, &parsed)) return 0;
+    uint32_t polymod = bech32_polymod(parsed.values, parsed.values_len);
+    if (!segwit_addr_decode_parsed(&parsed, polymod, witver, witprog, witprog_len)) return 0;
+    memcpy(hrp, parsed.hrp, parsed.hrp_len + 1);
+    return 1;
+}
+
 /* 内部实现：编码 segwit 地址
  * hrp: 人类可读部分
  * witver: witness 版本
@@ -216,24 +192,21 @@ static int segwit_addr_decode_internal(const char *addr, const char *hrp, int *w
  * 成功时返回 malloc 分配的地址字符串，失败返回 NULL。
  */
 static char *segwit_addr_encode_internal(const char *hrp, int witver, const uint8_t *witprog, size_t witprog_len) {
-    int in[200];
-    for (size_t i = 0; i < witprog_len; i++) {
-        in[i] = witprog[i];
-    }
-    int five_bit[200];
+    if (witver < 0 || witver > 16 || witprog_len > 65) return NULL;
+    uint8_t data[1 + 104];
     size_t five_bit_len;
-    if (!convertbits(in, witprog_len, 8, 5, 1, five_bit, &five_bit_len)) return NULL;
-    int data[201];
-    data[0] = witver;
-    memcpy(data + 1, five_bit, five_bit_len * sizeof(int));
+    if (!convertbits(witprog, witprog_len, 8, 5, 1, data + 1, &five_bit_len)) return NULL;
+    data[0] = (uint8_t)witver;
     size_t data_len = five_bit_len + 1;
-    char *ret = bech32_encode(hrp, data, data_len);
+    char *ret = bech32_encode(hrp, data, data_len, witver == 0 ? BECH32_CONST : BECH32M_CONST);
     if (ret == NULL) return NULL;
     /* 可选：验证编码结果 */
+    char hrp_decoded[BECH32_HRP_MAX + 1];
     int ver;
     uint8_t prog[40];
     size_t prog_len = sizeof(prog);
-    if (!segwit_addr_decode_internal(ret, hrp, &ver, prog, &prog_len)) {
+    if (!segwit_addr_decode_internal(ret, strlen(ret), hrp_decoded, &ver, prog, &prog_len) ||
+        strcmp(hrp_decoded, hrp) != 0) {
         free(ret);
         return NULL;
     }
@@ -253,6 +226,12 @@ int segwit_addr_encode(char *output, const char *hrp, int witver, const uint8_t
 
 /* segwit_addr_decode: 解码 Bech32 格式的 segwit 地址 */
 int segwit_addr_decode(const char *addr, const char *hrp, int *witver, uint8_t *witprog, size_t *witprog_len) {
-    return segwit_addr_decode_internal(addr, hrp, witver, witprog, witprog_len);
+    char hrp_decoded[BECH32_HRP_MAX + 1];
+    if (!segwit_addr_decode_internal(addr, strlen(addr), hrp_decoded, witver, witprog, witprog_len)) return 0;
+    return strcmp(hrp_decoded, hrp) == 0;
 }
 
+/* segwit_addr_decode_any: 解码一次并返回 HRP，由调用者判断 HRP 是否可接受 */
+int segwit_addr_decode_any(const char *addr, size_t len, char *hrp, int *witver, uint8_t *witprog, size_t *witprog_len) {
+    return segwit_addr_decode_internal(addr, len, hrp, witver, witprog, witprog_len);
+}
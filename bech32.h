@@ -11,8 +11,21 @@
 extern "C" {
 #endif
 
+/* HRP 的最大长度：地址最长 90 个字符，减去分隔符和 6 个校验字符 */
+#define BECH32_HRP_MAX 83
+/* 校验和计算的输入（HRP 扩展 + 数据部分 + 校验值）的最大长度：2 * 83 + 1 + 6 */
+#define BECH32_VALUES_MAX 173
+
+/* 解析后、校验前的 Bech32 字符串 */
+typedef struct {
+    char hrp[BECH32_HRP_MAX + 1];         /* 小写 HRP */
+    size_t hrp_len;
+    uint8_t values[BECH32_VALUES_MAX];    /* polymod 的输入：HRP 扩展后接数据部分的 5 位值（含校验值） */
+    size_t values_len;
+} Bech32Parsed;
+
 /**
- * segwit_addr_encode - 使用 Bech32 格式对 segwit 地址进行编码
+ * segwit_addr_encode - 对 segwit 地址进行编码：witness v0 使用 Bech32，v1～v16 使用 Bech32m（BIP-350）
  *
  * @output: 输出缓冲区，用于存放 null 结尾的地址字符串（调用者保证足够大）
  * @hrp: 人类可读部分（例如 "bc"）
@@ -25,7 +38,7 @@ extern "C" {
 int segwit_addr_encode(char *output, const char *hrp, int witver, const uint8_t *witprog, size_t witprog_len);
 
 /**
- * segwit_addr_decode - 解码 Bech32 格式的 segwit 地址
+ * segwit_addr_decode - 解码 Bech32/Bech32m 格式的 segwit 地址（校验和类型必须与 witness 版本相符）
  *
  * @addr: 输入的 Bech32 地址字符串
  * @hrp: 预期的人类可读部分（例如 "bc"）
@@ -37,6 +50,43 @@ int segwit_addr_encode(char *output, const char *hrp, int witver, const uint8_t
  */
 int segwit_addr_decode(const char *addr, const char *hrp, int *witver, uint8_t *witprog, size_t *witprog_len);
 
+
+/**
+ * segwit_addr_decode_any - 单遍解码 Bech32 格式的 segwit 地址，不限定 HRP
+ *
+ * @addr: 输入的 Bech32 地址字符串（不要求以 '\0' 结尾）
+ * @len: 地址长度
+ * @hrp: 输出缓冲区（至少 BECH32_HRP_MAX + 1 字节），保存解析出的小写 HRP，由调用者检查是否在允许的集合中
+ * @witver: 输出参数，保存解析出的 witness 版本
+ * @witprog: 输出缓冲区，用于保存解析出的 witness 程序（二进制数据）
+ * @witprog_len: 输入时为 witprog 缓冲区大小；输出时保存实际数据长度
+ *
+ * 成功返回 1，失败返回 0。
+ */
+int segwit_addr_decode_any(const char *addr, size_t len, char *hrp, int *witver, uint8_t *witprog, size_t *witprog_len);
+
+/**
+ * bech32_parse - 解析 Bech32 字符串但不校验，用于把多个地址的校验和交给 bech32_polymod_batch 一起计算
+ *
+ * @addr: 输入的 Bech32 地址字符串（不要求以 '\0' 结尾）
+ * @len: 地址长度
+ * @parsed: 输出解析结果，其 values 即 polymod 的输入
+ *
+ * 成功返回 1，失败返回 0。
+ */
+int bech32_parse(const char *addr, size_t len, Bech32Parsed *parsed);
+
+/**
+ * segwit_addr_decode_parsed - 由 bech32_parse 的结果及其 polymod 值完成 segwit 地址解码
+ *
+ * @parsed: bech32_parse 的输出
+ * @polymod: bech32_polymod(parsed->values, parsed->values_len) 的结果
+ * @witver/@witprog/@witprog_len: 同 segwit_addr_decode
+ *
+ * 成功返回 1，失败返回 0。HRP 由调用者通过 parsed->hrp 检查。
+ */
+int segwit_addr_decode_parsed(const Bech32Parsed *parsed, uint32_t polymod, int *witver, uint8_t *witprog, size_t *witprog_len);
+
 #ifdef __cplusplus
 }
 #endif
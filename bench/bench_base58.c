@@ -0,0 +1,136 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+// Base58 解碼微基準：在相同的輸入上比較逐字節的 base58_decode（b58tobin / base58_decode_check）
+// 與按 32 位字解碼的 b58tobin_fast / b58check_tobin。
+// make bench_base58
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "base58.h"
+
+#define ADDR_COUNT 65536
+#define ROUNDS     8
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// 生成地址：P2PKH/P2SH（21 字節 payload）與 Zcash 透明地址（22 字節 payload）混合
+static char **make_addresses(size_t count) {
+    char **addrs = (char **)malloc(count * sizeof(char *));
+    if (!addrs) return NULL;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t payload[22];
+        size_t len = 21;
+        switch (i % 4) {
+            case 0: case 1: payload[0] = 0x00; break;
+            case 2: payload[0] = 0x05; break;
+            default: payload[0] = 0x1c; payload[1] = 0xb8; len = 22; break;
+        }
+        for (size_t j = len - 20; j < len; j++) payload[j] = (uint8_t)rng_next();
+        addrs[i] = base58_encode_check(payload, len);
+        if (!addrs[i]) return NULL;
+    }
+    return addrs;
+}
+
+typedef int (*decode_fn)(const char *addr, size_t len, uint8_t *out, size_t *out_len);
+
+static int run_b58tobin(const char *addr, size_t len, uint8_t *out, size_t *out_len) {
+    return b58tobin(out, out_len, addr, len);
+}
+
+static int run_b58tobin_fast(const char *addr, size_t len, uint8_t *out, size_t *out_len) {
+    return b58tobin_fast(out, out_len, addr, len);
+}
+
+static int run_base58_decode_check(const char *addr, size_t len, uint8_t *out, size_t *out_len) {
+    (void)len;
+    uint8_t *payload = base58_decode_check(addr, out_len);
+    if (!payload) return 0;
+    memcpy(out, payload, *out_len);
+    free(payload);
+    return 1;
+}
+
+static int run_b58check_tobin(const char *addr, size_t len, uint8_t *out, size_t *out_len) {
+    return b58check_tobin(out, out_len, addr, len);
+}
+
+static double bench(decode_fn fn, char **addrs, const size_t *lens, size_t count, uint64_t *checksum) {
+    double best = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        uint64_t sum = 0;
+        double t0 = now_ns();
+        for (size_t i = 0; i < count; i++) {
+            uint8_t out[64];
+            size_t out_len = sizeof(out);
+            if (fn(addrs[i], lens[i], out, &out_len)) {
+                sum += out[out_len - 1] + out_len;
+            }
+        }
+        double t = (now_ns() - t0) / (double)count;
+        if (r == 0 || t < best) best = t;
+        *checksum = sum;
+    }
+    return best;
+}
+
+int main(void) {
+    char **addrs = make_addresses(ADDR_COUNT);
+    size_t *lens = (size_t *)malloc(ADDR_COUNT * sizeof(size_t));
+    if (!addrs || !lens) {
+        fprintf(stderr, "內存分配失敗。\n");
+        return 1;
+    }
+    for (size_t i = 0; i < ADDR_COUNT; i++) lens[i] = strlen(addrs[i]);
+
+    // 先確認兩種實現的結果逐字節一致
+    for (size_t i = 0; i < ADDR_COUNT; i++) {
+        uint8_t a[64], b[64];
+        size_t la = sizeof(a), lb = sizeof(b);
+        if (!b58tobin(a, &la, addrs[i], lens[i]) || !b58tobin_fast(b, &lb, addrs[i], lens[i]) ||
+            la != lb || memcmp(a, b, la) != 0) {
+            fprintf(stderr, "結果不一致: %s\n", addrs[i]);
+            return 1;
+        }
+    }
+
+    struct {
+        const char *name;
+        decode_fn fn;
+    } cases[] = {
+        {"b58tobin (byte-wise)",      run_b58tobin},
+        {"b58tobin_fast (limbs)",     run_b58tobin_fast},
+        {"base58_decode_check",       run_base58_decode_check},
+        {"b58check_tobin",            run_b58check_tobin},
+    };
+
+    printf("%-26s %10s %14s\n", "decoder", "ns/op", "addresses/s");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint64_t checksum = 0;
+        double ns = bench(cases[c].fn, addrs, lens, ADDR_COUNT, &checksum);
+        printf("%-26s %10.1f %14.0f   (checksum %llu)\n", cases[c].name, ns, 1e9 / ns,
+               (unsigned long long)checksum);
+    }
+
+    for (size_t i = 0; i < ADDR_COUNT; i++) free(addrs[i]);
+    free(addrs);
+    free(lens);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+// 十六進制編解碼微基準：比較原來逐字節 sprintf("%02x") / sscanf("%2x") 的實現與 hex.c 的查表/SIMD 實現。
+// 每行的開銷：成功行編碼一個 20 字節 hash160，十六進制地址行解碼 40 或 64 個字符，
+// 其他格式都失敗的行最後由十六進制解碼器拒絕。
+// make bench_hex
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "hex.h"
+
+#define LINE_COUNT 65536
+#define ROUNDS     8
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// 原來 main.c 中的實現
+static void bytes_to_hex_sprintf(const unsigned char *bytes, size_t len, char *hex_str) {
+    for (size_t i = 0; i < len; i++) {
+        sprintf(&hex_str[i * 2], "%02x", bytes[i]);
+    }
+    hex_str[len * 2] = '\0';
+}
+
+static int hex_to_bytes_sscanf(const char *hex_str, unsigned char *bytes_out, size_t max_len) {
+    size_t len = strlen(hex_str);
+    if (len % 2 != 0) {
+        return 0;
+    }
+    size_t bytes_len = len / 2;
+    if (bytes_len > max_len) {
+        return 0;
+    }
+    for (size_t i = 0; i < bytes_len; i++) {
+        unsigned int val;
+        if (sscanf(hex_str + (i * 2), "%2x", &val) != 1) {
+            return 0;
+        }
+        bytes_out[i] = (unsigned char)val;
+    }
+    return (int)bytes_len;
+}
+
+static int hex_to_bytes_table(const char *hex_str, unsigned char *bytes_out, size_t max_len) {
+    int n = hex_decode(hex_str, strlen(hex_str), bytes_out, max_len);
+    return n < 0 ? 0 : n;
+}
+
+typedef int (*decode_fn)(const char *hex_str, unsigned char *bytes_out, size_t max_len);
+typedef void (*encode_fn)(const unsigned char *bytes, size_t len, char *hex_str);
+
+static double bench_encode(encode_fn fn, const uint8_t *bytes, size_t count, uint64_t *checksum) {
+    double best = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        uint64_t sum = 0;
+        double t0 = now_ns();
+        for (size_t i = 0; i < count; i++) {
+            char hex[41];
+            fn(bytes + i * 20, 20, hex);
+            sum += (uint8_t)hex[i % 40];
+        }
+        double t = (now_ns() - t0) / (double)count;
+        if (r == 0 || t < best) best = t;
+        *checksum = sum;
+    }
+    return best;
+}
+
+static double bench_decode(decode_fn fn, char **lines, size_t count, uint64_t *checksum) {
+    double best = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        uint64_t sum = 0;
+        double t0 = now_ns();
+        for (size_t i = 0; i < count; i++) {
+            unsigned char out[64];
+            int n = fn(lines[i], out, sizeof(out));
+            sum += n > 0 ? out[n - 1] + (uint64_t)n : 1;
+        }
+        double t = (now_ns() - t0) / (double)count;
+        if (r == 0 || t < best) best = t;
+        *checksum = sum;
+    }
+    return best;
+}
+
+// 生成 count 行 nbytes 字節的十六進制串（大小寫混合）；bad 非零時每行中間插入一個非十六進制字符
+static char **make_hex_lines(size_t count, size_t nbytes, int bad) {
+    char **lines = (char **)malloc(count * sizeof(char *));
+    if (!lines) return NULL;
+    for (size_t i = 0; i < count; i++) {
+        lines[i] = (char *)malloc(2 * nbytes + 1);
+        if (!lines[i]) return NULL;
+        for (size_t j = 0; j < 2 * nbytes; j++) {
+            uint64_t r = rng_next();
+            lines[i][j] = (r & 16) ? "0123456789abcdef"[r & 15] : "0123456789ABCDEF"[r & 15];
+        }
+        lines[i][2 * nbytes] = '\0';
+        if (bad) lines[i][nbytes + (i % nbytes)] = 'x';
+    }
+    return lines;
+}
+
+int main(void) {
+    uint8_t *bytes = (uint8_t *)malloc(LINE_COUNT * 20);
+    char **hex40 = make_hex_lines(LINE_COUNT, 20, 0);
+    char **hex64 = make_hex_lines(LINE_COUNT, 32, 0);
+    char **bad = make_hex_lines(LINE_COUNT, 32, 1);
+    if (!bytes || !hex40 || !hex64 || !bad) {
+        fprintf(stderr, "內存分配失敗。\n");
+        return 1;
+    }
+    for (size_t i = 0; i < LINE_COUNT * 20; i++) bytes[i] = (uint8_t)rng_next();
+
+    // 先確認兩種實現的結果一致
+    for (size_t i = 0; i < LINE_COUNT; i++) {
+        char a[41], b[41];
+        unsigned char x[64], y[64];
+        bytes_to_hex_sprintf(bytes + i * 20, 20, a);
+        hex_encode(bytes + i * 20, 20, b);
+        int nx = hex_to_bytes_sscanf(hex64[i], x, sizeof(x));
+        int ny = hex_to_bytes_table(hex64[i], y, sizeof(y));
+        if (strcmp(a, b) != 0 || nx != ny || memcmp(x, y, (size_t)nx) != 0 ||
+            hex_to_bytes_table(bad[i], y, sizeof(y)) != 0) {
+            fprintf(stderr, "結果不一致: %zu\n", i);
+            return 1;
+        }
+    }
+
+    printf("%-34s %10s %14s\n", "case", "ns/line", "lines/s");
+
+    struct {
+        const char *name;
+        encode_fn fn;
+    } enc[] = {
+        {"encode 20 bytes  sprintf",      bytes_to_hex_sprintf},
+        {"encode 20 bytes  hex_encode",   hex_encode},
+    };
+    for (size_t c = 0; c < sizeof(enc) / sizeof(enc[0]); c++) {
+        uint64_t checksum = 0;
+        double ns = bench_encode(enc[c].fn, bytes, LINE_COUNT, &checksum);
+        printf("%-34s %10.1f %14.0f   (checksum %llu)\n", enc[c].name, ns, 1e9 / ns,
+               (unsigned long long)checksum);
+    }
+
+    struct {
+        const char *name;
+        decode_fn fn;
+        char **lines;
+    } dec[] = {
+        {"decode 40 chars  sscanf",       hex_to_bytes_sscanf, hex40},
+        {"decode 40 chars  hex_decode",   hex_to_bytes_table,  hex40},
+        {"decode 64 chars  sscanf",       hex_to_bytes_sscanf, hex64},
+        {"decode 64 chars  hex_decode",   hex_to_bytes_table,  hex64},
+        {"reject 64 chars  sscanf",       hex_to_bytes_sscanf, bad},
+        {"reject 64 chars  hex_decode",   hex_to_bytes_table,  bad},
+    };
+    for (size_t c = 0; c < sizeof(dec) / sizeof(dec[0]); c++) {
+        uint64_t checksum = 0;
+        double ns = bench_decode(dec[c].fn, dec[c].lines, LINE_COUNT, &checksum);
+        printf("%-34s %10.1f %14.0f   (checksum %llu)\n", dec[c].name, ns, 1e9 / ns,
+               (unsigned long long)checksum);
+    }
+
+    for (size_t i = 0; i < LINE_COUNT; i++) {
+        free(hex40[i]);
+        free(hex64[i]);
+        free(bad[i]);
+    }
+    free(hex40);
+    free(hex64);
+    free(bad);
+    free(bytes);
+    return 0;
+}
@@ -0,0 +1,864 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+// 基準測試套件：各解碼器、SHA-256、排序去重的微基準，以及 decode 在多個線程數下的端到端吞吐量。
+// 每項重複測量直到用滿最短時間，報告中位數和離散度（P10–P90 的半寬相對中位數）。
+// 結果以表格輸出到終端，並寫成 JSON 文件，可用 --baseline 與舊的結果比較，發現性能回退。
+// 基準之前先做正確性檢查（布隆過濾器的文件往返與實測誤判率、zstd 幀長度的解析），任一項不通過則退出碼為 1；
+// --check（make check）只做檢查。
+// make bench / make check
+// ./bench/bench_suite [--check] [-o results.json] [--decode ./decode] [--lines n] [--threads 1,2,4]
+//                     [--input dump.tsv] [--min-time 0.5] [--baseline old.json] [--tolerance 0.10]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "base58.h"
+#include "bech32.h"
+#include "bloom.h"
+#include "cashaddr.h"
+#include "decompress.h"
+#include "hashsort.h"
+#include "hex.h"
+#include "sha256.h"
+
+#define ITEM_COUNT  65536
+#define SAMPLE_ITEMS 4096        // 每次測量處理的輸入數；樣本短而多，中位數不易受偶發干擾影響
+#define MIN_SAMPLES 10
+#define MAX_SAMPLES 10000
+#define SORT_KEYS   (1u << 20)
+#define E2E_LINES   1000000
+#define E2E_RUNS    5
+#define MAX_RESULTS 64
+#define MAX_CHECKS  32
+#define BLOOM_KEYS  (1u << 20)
+#define MAX_THREADS 16
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// 一條結果；端到端結果的 ns_per_op 是每行的耗時，便於與基線統一比較
+typedef struct {
+    char name[64];
+    double ns_per_op;            // 各次測量的中位數
+    double spread;               // (P90 - P10) / 2 / 中位數
+    int samples;
+    int threads;                 // 0 表示微基準
+    size_t lines;
+    double seconds;
+} BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static int result_count;
+
+// 一項正確性檢查；measured 與 target 的含義由檢查自己決定（布隆過濾器為誤判率）
+typedef struct {
+    char name[64];
+    double target;
+    double measured;
+    int ok;
+} CheckResult;
+
+static CheckResult checks[MAX_CHECKS];
+static int check_count;
+static FILE *report;             // 表格輸出；JSON 寫到標準輸出時改為標準錯誤
+static double min_time_ns = 0.5e9;
+
+// 已測 n 次、累計 elapsed 納秒後是否還要繼續：至少 MIN_SAMPLES 次，並用滿最短時間
+static int keep_sampling(int n, double elapsed) {
+    return n < MIN_SAMPLES || (elapsed < min_time_ns && n < MAX_SAMPLES);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// 已排序樣本的 q 分位數（線性插值）
+static double quantile(const double *sorted, int n, double q) {
+    double pos = q * (n - 1);
+    int lo = (int)pos;
+    if (lo + 1 >= n) return sorted[n - 1];
+    return sorted[lo] + (sorted[lo + 1] - sorted[lo]) * (pos - lo);
+}
+
+// 由每次測量的每操作耗時 samples[0..n) 匯總一條結果（會就地排序 samples）
+static int add_check(const char *name, double target, double measured, int ok) {
+    if (check_count < MAX_CHECKS) {
+        CheckResult *c = &checks[check_count++];
+        snprintf(c->name, sizeof(c->name), "%s", name);
+        c->target = target;
+        c->measured = measured;
+        c->ok = ok;
+    }
+    fprintf(report, "%-28s %12.3g %12.3g   %s\n", name, target, measured, ok ? "ok" : "FAIL");
+    return ok ? 0 : -1;
+}
+
+static void add_result(const char *name, double *samples, int n, int threads, size_t lines) {
+    if (result_count == MAX_RESULTS || n == 0) return;
+    qsort(samples, (size_t)n, sizeof(double), compare_double);
+    BenchResult *r = &results[result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->ns_per_op = quantile(samples, n, 0.5);
+    r->spread = (quantile(samples, n, 0.9) - quantile(samples, n, 0.1)) / 2 / r->ns_per_op;
+    r->samples = n;
+    r->threads = threads;
+    r->lines = lines;
+    r->seconds = r->ns_per_op * (double)lines / 1e9;
+    if (threads == 0) {
+        fprintf(report, "%-28s %10.1f %14.0f %7.1f%% %6d\n", name, r->ns_per_op, 1e9 / r->ns_per_op,
+                r->spread * 100, n);
+    } else {
+        fprintf(report, "%-28s %10.1f %14.0f %7.1f%% %6d   (%.3f s)\n", name, r->ns_per_op, 1e9 / r->ns_per_op,
+                r->spread * 100, n, r->seconds);
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * 測試數據
+ * -------------------------------------------------------------------------*/
+
+static void random_bytes(uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) p[i] = (uint8_t)rng_next();
+}
+
+static char *make_base58(void) {
+    uint8_t payload[21];
+    payload[0] = (rng_next() & 1) ? 0x00 : 0x05;
+    random_bytes(payload + 1, 20);
+    return base58_encode_check(payload, sizeof(payload));
+}
+
+static char *make_segwit(int witver) {
+    uint8_t prog[32];
+    size_t len = witver == 0 ? 20 : 32;
+    random_bytes(prog, len);
+    char *out = (char *)malloc(128);
+    if (out && !segwit_addr_encode(out, "bc", witver, prog, len)) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+static char *make_cashaddr(void) {
+    uint8_t hash[20];
+    char hex[41];
+    random_bytes(hash, 20);
+    hex_encode(hash, 20, hex);
+    char *out = (char *)malloc(128);
+    if (out && encode_cashaddr("bitcoincash", 0, "P2PKH", hex, out, 128) != 0) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+static char *make_hex(void) {
+    uint8_t hash[20];
+    random_bytes(hash, 20);
+    char *out = (char *)malloc(41);
+    if (out) hex_encode(hash, 20, out);
+    return out;
+}
+
+// 生成 count 個 make() 的結果，出錯時返回 NULL
+static char **make_items(char *(*make)(void), size_t count) {
+    char **items = (char **)malloc(count * sizeof(char *));
+    if (!items) return NULL;
+    for (size_t i = 0; i < count; i++) {
+        items[i] = make();
+        if (!items[i]) return NULL;
+    }
+    return items;
+}
+
+static char *make_segwit_v0(void) { return make_segwit(0); }
+static char *make_segwit_v1(void) { return make_segwit(1); }
+
+static void free_items(char **items, size_t count) {
+    if (!items) return;
+    for (size_t i = 0; i < count; i++) free(items[i]);
+    free(items);
+}
+
+/* -------------------------------------------------------------------------
+ * 微基準
+ * -------------------------------------------------------------------------*/
+
+// 每次測量依次取 items 中接下來的 SAMPLE_ITEMS 個逐個調用 fn，每次測量的每次調用耗時（納秒）存入 samples，
+// 返回測量次數。count 須為 SAMPLE_ITEMS 的倍數
+typedef int (*item_fn)(const char *item, size_t len, uint8_t *out);
+
+static int bench_items(item_fn fn, char **items, const size_t *lens, size_t count, double *samples,
+                       uint64_t *checksum) {
+    int n = 0;
+    double elapsed = 0;
+    size_t base = 0;
+    while (keep_sampling(n, elapsed)) {
+        uint64_t sum = 0;
+        double t0 = now_ns();
+        for (size_t i = base; i < base + SAMPLE_ITEMS; i++) {
+            uint8_t out[64];
+            int len = fn(items[i], lens[i], out);
+            sum += len > 0 ? out[len - 1] + (uint64_t)len : 1;
+        }
+        double t = now_ns() - t0;
+        elapsed += t;
+        samples[n++] = t / SAMPLE_ITEMS;
+        base = (base + SAMPLE_ITEMS) % count;
+        *checksum = sum;
+    }
+    return n;
+}
+
+static int run_base58_decode_check(const char *item, size_t len, uint8_t *out) {
+    (void)len;
+    size_t n;
+    uint8_t *payload = base58_decode_check(item, &n);
+    if (!payload) return 0;
+    memcpy(out, payload, n);
+    free(payload);
+    return (int)n;
+}
+
+static int run_b58check_tobin(const char *item, size_t len, uint8_t *out) {
+    size_t n = 64;
+    return b58check_tobin(out, &n, item, len) ? (int)n : 0;
+}
+
+static int run_segwit_addr_decode(const char *item, size_t len, uint8_t *out) {
+    (void)len;
+    int witver;
+    size_t n = 40;
+    return segwit_addr_decode(item, "bc", &witver, out, &n) ? (int)n : 0;
+}
+
+static int run_decode_cashaddr(const char *item, size_t len, uint8_t *out) {
+    (void)len;
+    CashAddrResult result;
+    if (decode_cashaddr(item, &result) != 0) return 0;
+    memcpy(out, result.hash160, 40);
+    return 40;
+}
+
+static int run_decode_cashaddr_bin(const char *item, size_t len, uint8_t *out) {
+    (void)len;
+    uint8_t version;
+    size_t n = 64;
+    return decode_cashaddr_bin(item, &version, out, &n) == 0 ? (int)n : 0;
+}
+
+static int run_hex_decode(const char *item, size_t len, uint8_t *out) {
+    int n = hex_decode(item, len, out, 64);
+    return n < 0 ? 0 : n;
+}
+
+static int run_sha256(const char *item, size_t len, uint8_t *out) {
+    sha256((const uint8_t *)item, len, out);
+    return 32;
+}
+
+static int run_sha256d_short(const char *item, size_t len, uint8_t *out) {
+    sha256d_short((const uint8_t *)item, len < SHA256D_SHORT_MAX ? len : SHA256D_SHORT_MAX, out);
+    return 32;
+}
+
+static int bench_codec(const char *name, item_fn fn, char *(*make)(void)) {
+    char **items = make_items(make, ITEM_COUNT);
+    size_t *lens = (size_t *)malloc(ITEM_COUNT * sizeof(size_t));
+    if (!items || !lens) {
+        fprintf(stderr, "測試數據生成失敗: %s\n", name);
+        free(lens);
+        return -1;
+    }
+    for (size_t i = 0; i < ITEM_COUNT; i++) lens[i] = strlen(items[i]);
+
+    // 先確認每個輸入都能解碼，避免測到的是失敗路徑
+    uint8_t out[64];
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        if (fn(items[i], lens[i], out) <= 0) {
+            fprintf(stderr, "%s 無法解碼: %s\n", name, items[i]);
+            free_items(items, ITEM_COUNT);
+            free(lens);
+            return -1;
+        }
+    }
+
+    uint64_t checksum = 0;
+    double samples[MAX_SAMPLES];
+    int n = bench_items(fn, items, lens, ITEM_COUNT, samples, &checksum);
+    add_result(name, samples, n, 0, 0);
+    free_items(items, ITEM_COUNT);
+    free(lens);
+    return 0;
+}
+
+// Base58Check 校驗的批量路徑：每次 64 個地址，與 main.c 的分階段解碼相同
+static int bench_b58_batch(void) {
+    char **items = make_items(make_base58, ITEM_COUNT);
+    uint8_t (*bins)[32] = (uint8_t (*)[32])malloc(ITEM_COUNT * sizeof(*bins));
+    size_t *lens = (size_t *)malloc(ITEM_COUNT * sizeof(size_t));
+    if (!items || !bins || !lens) {
+        free(bins);
+        free(lens);
+        return -1;
+    }
+    double samples[MAX_SAMPLES];
+    int n = 0;
+    double elapsed = 0;
+    size_t first = 0;
+    while (keep_sampling(n, elapsed)) {
+        double t0 = now_ns();
+        for (size_t base = first; base < first + SAMPLE_ITEMS; base += 64) {
+            const uint8_t *ptrs[64];
+            uint8_t ok[64];
+            for (size_t j = 0; j < 64; j++) {
+                lens[base + j] = sizeof(bins[0]);
+                b58tobin_fast(bins[base + j], &lens[base + j], items[base + j], strlen(items[base + j]));
+                ptrs[j] = bins[base + j];
+            }
+            b58check_verify_batch(ptrs, lens + base, 64, ok);
+        }
+        double t = now_ns() - t0;
+        elapsed += t;
+        samples[n++] = t / SAMPLE_ITEMS;
+        first = (first + SAMPLE_ITEMS) % ITEM_COUNT;
+    }
+    add_result("b58check batch (64)", samples, n, 0, 0);
+    free_items(items, ITEM_COUNT);
+    free(bins);
+    free(lens);
+    return 0;
+}
+
+// 排序去重：約三分之一的鍵重複出現，接近真實數據中同一 hash160 對應多種地址的情況
+static int bench_sort_dedup(void) {
+    uint8_t *src = (uint8_t *)malloc((size_t)SORT_KEYS * HASH160_SIZE);
+    uint8_t *keys = (uint8_t *)malloc((size_t)SORT_KEYS * HASH160_SIZE);
+    if (!src || !keys) {
+        free(src);
+        free(keys);
+        return -1;
+    }
+    for (size_t i = 0; i < SORT_KEYS; i++) {
+        if (i > 0 && rng_next() % 3 == 0) {
+            memcpy(src + i * HASH160_SIZE, src + (rng_next() % i) * HASH160_SIZE, HASH160_SIZE);
+        } else {
+            random_bytes(src + i * HASH160_SIZE, HASH160_SIZE);
+        }
+    }
+    double sort_samples[MAX_SAMPLES], dedup_samples[MAX_SAMPLES];
+    int n = 0;
+    double elapsed = 0;
+    while (keep_sampling(n, elapsed)) {
+        memcpy(keys, src, (size_t)SORT_KEYS * HASH160_SIZE);
+        double t0 = now_ns();
+        hash160_sort(keys, SORT_KEYS);
+        double t1 = now_ns();
+        hash160_dedup(keys, SORT_KEYS);
+        double t2 = now_ns();
+        elapsed += t2 - t0;
+        sort_samples[n] = (t1 - t0) / SORT_KEYS;
+        dedup_samples[n++] = (t2 - t1) / SORT_KEYS;
+    }
+    add_result("hash160_sort (1M keys)", sort_samples, n, 0, 0);
+    add_result("hash160_dedup (1M keys)", dedup_samples, n, 0, 0);
+    free(src);
+    free(keys);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * 正確性檢查
+ * -------------------------------------------------------------------------*/
+
+/*
+ * 布隆過濾器：按目標誤判率建過濾器並寫出 .bloom 文件，用 bloom_open 重新映射後
+ * 確認插入的鍵全部命中（不允許漏判），再用不在集合中的隨機鍵測量誤判率。
+ * 探測次數保證期望誤判數至少約 200 次，實測值超過目標 1.25 倍視為不通過。
+ */
+static int check_bloom(void) {
+    static const double targets[] = {0.05, 0.01, 1e-3, 1e-4, 1e-5};
+    const char *path = "bench/check.bloom";
+    uint8_t *keys = (uint8_t *)malloc((size_t)BLOOM_KEYS * 20);
+    if (!keys) return -1;
+    random_bytes(keys, (size_t)BLOOM_KEYS * 20);
+
+    int failed = 0;
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+        char name[64];
+        snprintf(name, sizeof(name), "bloom fpr %g", targets[t]);
+        Bloom built, opened;
+        if (bloom_init(&built, BLOOM_KEYS, targets[t]) != 0) {
+            failed |= add_check(name, targets[t], 1, 0);
+            continue;
+        }
+        bloom_add_keys(&built, keys, BLOOM_KEYS);
+        FILE *fp = fopen(path, "wb");
+        int wret = fp ? bloom_write(&built, fp) : -1;
+        if (fp && fclose(fp) != 0) wret = -1;
+        uint64_t blocks = built.block_count;
+        uint32_t k = built.k;
+        bloom_free(&built);
+        if (wret != 0 || bloom_open(path, &opened) != 0) {
+            fprintf(stderr, "%s: 寫出或重新打開 %s 失敗\n", name, path);
+            failed |= add_check(name, targets[t], 1, 0);
+            continue;
+        }
+        int ok = opened.block_count == blocks && opened.k == k && opened.key_count == BLOOM_KEYS;
+
+        size_t missing = 0;
+        for (size_t i = 0; i < BLOOM_KEYS; i++) missing += !bloom_contains(&opened, keys + i * 20);
+        if (missing) fprintf(stderr, "%s: %zu 個已插入的鍵未命中\n", name, missing);
+        ok = ok && missing == 0;
+
+        size_t probes = (size_t)(200 / targets[t]);
+        if (probes < BLOOM_KEYS) probes = BLOOM_KEYS;
+        size_t hits = 0;
+        for (size_t i = 0; i < probes; i++) {
+            uint8_t key[20];
+            random_bytes(key, sizeof(key));   // 與插入的鍵同分佈，碰巧相同的概率可以忽略
+            hits += bloom_contains(&opened, key);
+        }
+        double measured = (double)hits / (double)probes;
+        bloom_free(&opened);
+        failed |= add_check(name, targets[t], measured, ok && measured <= targets[t] * 1.25);
+    }
+    remove(path);
+    free(keys);
+    return failed;
+}
+
+/*
+ * 手工構造一個 zstd 幀：4 字節魔數、幀頭描述符 fhd、header 字節的窗口描述符/字典號/內容大小（填 0），
+ * 然後是 types/sizes 描述的各個塊（最後一個塊置結束位），校驗和標誌置位時補 4 字節。
+ * header 由調用者按 RFC 8878 手算後給出，不與被測的解析共用邏輯。返回寫入的字節數。
+ */
+static size_t make_zstd_frame(uint8_t *p, unsigned fhd, size_t header, const unsigned *types, const unsigned *sizes,
+                              int blocks) {
+    static const uint8_t magic[4] = {0x28, 0xb5, 0x2f, 0xfd};
+    memcpy(p, magic, 4);
+    p[4] = (uint8_t)fhd;
+    memset(p + 5, 0, header);
+    size_t pos = 5 + header;
+    for (int i = 0; i < blocks; i++) {
+        uint32_t bh = (uint32_t)(i + 1 == blocks) | types[i] << 1 | sizes[i] << 3;
+        p[pos] = (uint8_t)bh;
+        p[pos + 1] = (uint8_t)(bh >> 8);
+        p[pos + 2] = (uint8_t)(bh >> 16);
+        size_t body = types[i] == 1 ? 1 : sizes[i];   // RLE 塊只存一個字節
+        memset(p + pos + 3, 0x41, body);
+        pos += 3 + body;
+    }
+    if (fhd & 0x04) {
+        memset(p + pos, 0, 4);
+        pos += 4;
+    }
+    return pos;
+}
+
+static int check_frame(const char *name, const uint8_t *p, size_t avail, size_t expected) {
+    size_t got = decompress_zstd_frame_size(p, avail);
+    return add_check(name, (double)expected, (double)got, got == expected);
+}
+
+/*
+ * zstd 幀長度：並行解壓靠它在幀邊界上切分文件，算錯一個字節就會把幀從中間切開。
+ * 覆蓋可跳過幀、校驗和、單段幀的各種內容大小字段、字典號、RLE/原始/壓縮塊、多塊，
+ * 以及截斷和保留位等必須拒絕（返回 0）的情形。
+ */
+static int check_zstd_frames(void) {
+    uint8_t buf[4096];
+    int failed = 0;
+    const unsigned raw[1] = {0}, raw_size[1] = {100};
+    const unsigned rle[1] = {1}, rle_size[1] = {1000};
+    const unsigned multi[3] = {2, 0, 1}, multi_size[3] = {50, 30, 500};
+    const unsigned reserved[1] = {3}, reserved_size[1] = {10};
+
+    static const uint8_t skippable[13] = {0x5a, 0x2a, 0x4d, 0x18, 5, 0, 0, 0, 1, 2, 3, 4, 5};
+    failed |= check_frame("zstd skippable frame", skippable, sizeof(skippable), sizeof(skippable));
+    failed |= check_frame("zstd skippable truncated", skippable, sizeof(skippable) - 1, 0);
+
+    // 原始塊 100 字節佔 103 字節；幀頭 5 字節（魔數 + 描述符）之後的字段長度見各行
+    size_t n = make_zstd_frame(buf, 0x00, 1, raw, raw_size, 1);   // 窗口描述符
+    failed |= check_frame("zstd window, raw block", buf, sizeof(buf), 109);
+    failed |= check_frame("zstd truncated frame", buf, n - 1, 0);
+    n = make_zstd_frame(buf, 0x04, 1, raw, raw_size, 1);
+    failed |= check_frame("zstd checksum flag", buf, sizeof(buf), 113);
+    failed |= check_frame("zstd truncated checksum", buf, n - 2, 0);
+    // 單段幀沒有窗口描述符，內容大小字段為 1/2/4/8 字節
+    static const size_t fcs_bytes[4] = {1, 2, 4, 8};
+    for (unsigned fcs = 0; fcs < 4; fcs++) {
+        char name[64];
+        snprintf(name, sizeof(name), "zstd single segment fcs=%u", fcs);
+        make_zstd_frame(buf, fcs << 6 | 0x20, fcs_bytes[fcs], raw, raw_size, 1);
+        failed |= check_frame(name, buf, sizeof(buf), 5 + fcs_bytes[fcs] + 103);
+    }
+    // 窗口描述符 1 字節 + 字典號 1/2/4 字節 + 內容大小 2 字節
+    static const size_t did_bytes[4] = {0, 1, 2, 4};
+    for (unsigned did = 1; did < 4; did++) {
+        char name[64];
+        snprintf(name, sizeof(name), "zstd dict id flag=%u", did);
+        make_zstd_frame(buf, 0x40 | did, 1 + did_bytes[did] + 2, raw, raw_size, 1);
+        failed |= check_frame(name, buf, sizeof(buf), 5 + 1 + did_bytes[did] + 2 + 103);
+    }
+    make_zstd_frame(buf, 0x24, 1, rle, rle_size, 1);   // RLE 塊解壓為 1000 字節，只存 1 字節
+    failed |= check_frame("zstd rle block", buf, sizeof(buf), 5 + 1 + 4 + 4);
+    n = make_zstd_frame(buf, 0x04, 1, multi, multi_size, 3);
+    failed |= check_frame("zstd multi-block", buf, sizeof(buf), 5 + 1 + 53 + 33 + 4 + 4);
+    // 幀後緊跟下一個幀：只返回第一個幀的長度
+    size_t m = make_zstd_frame(buf + n, 0x00, 1, raw, raw_size, 1);
+    failed |= check_frame("zstd two frames", buf, n + m, n);
+
+    make_zstd_frame(buf, 0x08, 1, raw, raw_size, 1);
+    failed |= check_frame("zstd reserved header bit", buf, sizeof(buf), 0);
+    make_zstd_frame(buf, 0x00, 1, reserved, reserved_size, 1);
+    failed |= check_frame("zstd reserved block type", buf, sizeof(buf), 0);
+    static const uint8_t not_zstd[8] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0};
+    failed |= check_frame("zstd wrong magic", not_zstd, sizeof(not_zstd), 0);
+    return failed;
+}
+
+/* -------------------------------------------------------------------------
+ * 端到端
+ * -------------------------------------------------------------------------*/
+
+// 生成端到端輸入：與真實導出文件相近的地址類型比例，夾雜無效行，每行帶一列餘額
+static int write_e2e_input(const char *path, size_t lines) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "address\tbalance\n");
+    for (size_t i = 0; i < lines - 1; i++) {
+        char *addr;
+        unsigned k = (unsigned)(rng_next() % 100);
+        if (k < 55) addr = make_base58();
+        else if (k < 75) addr = make_segwit_v0();
+        else if (k < 82) addr = make_segwit_v1();
+        else if (k < 90) addr = make_cashaddr();
+        else if (k < 95) addr = make_hex();
+        else {
+            addr = (char *)malloc(32);
+            if (addr) snprintf(addr, 32, "invalid-%llu", (unsigned long long)(rng_next() % 1000000));
+        }
+        if (!addr) {
+            fclose(fp);
+            return -1;
+        }
+        fprintf(fp, "%s\t%llu\n", addr, (unsigned long long)(rng_next() % 100000000));
+        free(addr);
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+static size_t count_lines(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    char buf[1 << 16];
+    size_t n, lines = 0;
+    int last = '\n';
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        for (size_t i = 0; i < n; i++) lines += buf[i] == '\n';
+        last = buf[n - 1];
+    }
+    fclose(fp);
+    return lines + (last != '\n');
+}
+
+// 運行一次 decode，標準輸出丟棄。返回耗時（秒），失敗返回負數
+static double run_decode(const char *decode, const char *input, const char *prefix, int threads) {
+    char tbuf[16];
+    snprintf(tbuf, sizeof(tbuf), "%d", threads);
+    double t0 = now_ns();
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        int fd = open("/dev/null", O_WRONLY);
+        if (fd >= 0) dup2(fd, STDOUT_FILENO);
+        execl(decode, decode, "-t", tbuf, "-o", prefix, input, (char *)NULL);
+        _exit(127);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    double t = (now_ns() - t0) / 1e9;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? t : -1;
+}
+
+static int bench_end_to_end(const char *decode, const char *input, const int *threads, int nthreads) {
+    size_t lines = count_lines(input);
+    if (lines == 0) {
+        fprintf(stderr, "無法讀取端到端輸入: %s\n", input);
+        return -1;
+    }
+    const char *prefix = "bench/e2e_out";
+    for (int i = 0; i < nthreads; i++) {
+        double samples[E2E_RUNS];
+        for (int r = 0; r < E2E_RUNS; r++) {
+            double t = run_decode(decode, input, prefix, threads[i]);
+            if (t < 0) {
+                fprintf(stderr, "運行 %s 失敗。\n", decode);
+                return -1;
+            }
+            samples[r] = t * 1e9 / (double)lines;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "decode -t %d", threads[i]);
+        add_result(name, samples, E2E_RUNS, threads[i], lines);
+    }
+    remove("bench/e2e_out_success.txt");
+    remove("bench/e2e_out_failure.txt");
+    return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * JSON 輸出與基線比較
+ * -------------------------------------------------------------------------*/
+
+// 每條結果一行，--baseline 按行解析，不需要通用的 JSON 解析器
+static int write_json(const char *path) {
+    FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!fp) {
+        perror("無法寫入結果文件");
+        return -1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(fp, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+    fprintf(fp, "  \"sha256_impl\": \"%s\",\n", sha256_impl_name());
+    fprintf(fp, "  \"sha256d_batch_impl\": \"%s\",\n", sha256d_batch_impl_name());
+    fprintf(fp, "  \"checks\": [\n");
+    for (int i = 0; i < check_count; i++) {
+        const CheckResult *c = &checks[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"target\": %g, \"measured\": %g, \"ok\": %s}%s\n",
+                c->name, c->target, c->measured, c->ok ? "true" : "false", i + 1 < check_count ? "," : "");
+    }
+    fprintf(fp, "  ],\n");
+    fprintf(fp, "  \"results\": [\n");
+    for (int i = 0; i < result_count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"spread\": %.4f, \"samples\": %d, \"ops_per_sec\": %.0f",
+                r->name, r->ns_per_op, r->spread, r->samples, 1e9 / r->ns_per_op);
+        if (r->threads > 0) {
+            fprintf(fp, ", \"threads\": %d, \"lines\": %zu, \"seconds\": %.4f, \"lines_per_sec\": %.0f",
+                    r->threads, r->lines, r->seconds, (double)r->lines / r->seconds);
+        }
+        fprintf(fp, "}%s\n", i + 1 < result_count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    if (fp != stdout && fclose(fp) != 0) {
+        perror("無法寫入結果文件");
+        return -1;
+    }
+    return 0;
+}
+
+// 與基線逐項比較中位數。耗時增加既超過 tolerance、又超過新舊兩次測量的離散度之和時才視為回退，
+// 測量本身的抖動不會被當成回退。返回回退的項數，讀取失敗返回 -1
+static int compare_baseline(const char *path, double tolerance) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror("無法讀取基線文件");
+        return -1;
+    }
+    int regressions = 0;
+    char line[512];
+    fprintf(report, "\n%-28s %10s %10s %9s %9s\n", "compared to baseline", "old ns", "new ns", "change", "noise");
+    while (fgets(line, sizeof(line), fp)) {
+        char *name = strstr(line, "\"name\": \"");
+        char *ns = strstr(line, "\"ns_per_op\": ");
+        char *spread = strstr(line, "\"spread\": ");
+        if (!name || !ns) continue;
+        name += 9;
+        char *end = strchr(name, '"');
+        if (!end) continue;
+        *end = '\0';
+        double old_ns = strtod(ns + 13, NULL);
+        double old_spread = spread ? strtod(spread + 10, NULL) : 0;
+        for (int i = 0; i < result_count; i++) {
+            if (strcmp(results[i].name, name) != 0 || old_ns <= 0) continue;
+            double change = results[i].ns_per_op / old_ns - 1.0;
+            double noise = old_spread + results[i].spread;
+            int regressed = change > tolerance && change > noise;
+            regressions += regressed;
+            fprintf(report, "%-28s %10.1f %10.1f %+8.1f%% %8.1f%%%s\n", name, old_ns, results[i].ns_per_op,
+                    change * 100, noise * 100, regressed ? "  REGRESSION" : "");
+        }
+    }
+    fclose(fp);
+    return regressions;
+}
+
+/* -------------------------------------------------------------------------
+ * main
+ * -------------------------------------------------------------------------*/
+
+static int parse_threads(const char *s, int *threads) {
+    int n = 0;
+    while (*s && n < MAX_THREADS) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 1 || v > 4096) return 0;
+        threads[n++] = (int)v;
+        s = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return 0;
+    }
+    return n;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage  : %s [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "         --check              Only run the correctness checks (Bloom filter FPR, zstd frame parsing)\n");
+    fprintf(stderr, "         -o <file>            Write results as JSON (default: bench/results.json, \"-\" for stdout)\n");
+    fprintf(stderr, "         --decode <path>      decode binary for the end-to-end runs (default: ./decode)\n");
+    fprintf(stderr, "         --input <file>       End-to-end input (default: %d generated lines)\n", E2E_LINES);
+    fprintf(stderr, "         --lines <n>          Number of generated end-to-end lines\n");
+    fprintf(stderr, "         --threads <list>     Comma-separated thread counts (default: 1,2,4,... up to the CPU count)\n");
+    fprintf(stderr, "         --no-e2e             Only run the microbenchmarks\n");
+    fprintf(stderr, "         --min-time <sec>     Minimum measuring time per microbenchmark (default: 0.5)\n");
+    fprintf(stderr, "         --baseline <file>    Compare with an earlier JSON result; exit 1 on regressions\n");
+    fprintf(stderr, "         --tolerance <frac>   Allowed slowdown before a result counts as a regression (default: 0.10);\n");
+    fprintf(stderr, "                              a slowdown within the measured spread is never a regression\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *json_path = "bench/results.json";
+    const char *decode = "./decode";
+    const char *input = NULL;
+    const char *baseline = NULL;
+    size_t lines = E2E_LINES;
+    double tolerance = 0.10;
+    int threads[MAX_THREADS];
+    int nthreads = 0;
+    int e2e = 1;
+    int check_only = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--decode") == 0 && i + 1 < argc) {
+            decode = argv[++i];
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input = argv[++i];
+        } else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            long long v = atoll(argv[++i]);
+            if (v < 2) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            lines = (size_t)v;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            nthreads = parse_threads(argv[++i], threads);
+            if (nthreads == 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check_only = 1;
+        } else if (strcmp(argv[i], "--no-e2e") == 0) {
+            e2e = 0;
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            char *end;
+            double v = strtod(argv[++i], &end);
+            if (*end != '\0' || v < 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            min_time_ns = v * 1e9;
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            char *end;
+            tolerance = strtod(argv[++i], &end);
+            if (*end != '\0' || tolerance < 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nthreads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int t = 1; nthreads < MAX_THREADS; t *= 2) {
+            threads[nthreads++] = t;
+            if (t >= cpus) break;
+        }
+    }
+
+    report = strcmp(json_path, "-") == 0 ? stderr : stdout;
+    fprintf(report, "%-28s %12s %12s\n", "check", "target", "measured");
+    if ((check_bloom() | check_zstd_frames()) != 0) {
+        fprintf(stderr, "正確性檢查未通過\n");
+        return 1;
+    }
+    if (check_only) {
+        return 0;
+    }
+
+    fprintf(report, "\nsha256: %s, sha256d batch: %s\n\n", sha256_impl_name(), sha256d_batch_impl_name());
+    fprintf(report, "%-28s %10s %14s %8s %6s\n", "benchmark", "ns/op", "ops/s", "spread", "runs");
+    int failed = 0;
+    failed |= bench_codec("base58_decode_check", run_base58_decode_check, make_base58);
+    failed |= bench_codec("b58check_tobin", run_b58check_tobin, make_base58);
+    failed |= bench_b58_batch();
+    failed |= bench_codec("segwit_addr_decode (v0)", run_segwit_addr_decode, make_segwit_v0);
+    failed |= bench_codec("segwit_addr_decode (v1)", run_segwit_addr_decode, make_segwit_v1);
+    failed |= bench_codec("decode_cashaddr", run_decode_cashaddr, make_cashaddr);
+    failed |= bench_codec("decode_cashaddr_bin", run_decode_cashaddr_bin, make_cashaddr);
+    failed |= bench_codec("hex_decode (40 chars)", run_hex_decode, make_hex);
+    failed |= bench_codec("sha256 (address string)", run_sha256, make_base58);
+    failed |= bench_codec("sha256d_short (address)", run_sha256d_short, make_base58);
+    failed |= bench_sort_dedup();
+
+    if (e2e && !failed) {
+        const char *generated = "bench/e2e_input.tsv";
+        if (!input) {
+            if (write_e2e_input(generated, lines) != 0) {
+                fprintf(stderr, "無法生成端到端輸入: %s\n", generated);
+                return 1;
+            }
+            input = generated;
+        }
+        fprintf(report, "\n%-28s %10s %14s %8s %6s\n", "end-to-end", "ns/line", "lines/s", "spread", "runs");
+        failed |= bench_end_to_end(decode, input, threads, nthreads);
+        if (input == generated) remove(generated);
+    }
+    if (failed) {
+        return 1;
+    }
+    if (write_json(json_path) != 0) {
+        return 1;
+    }
+    if (strcmp(json_path, "-") != 0) {
+        fprintf(report, "\nResults written to %s\n", json_path);
+    }
+    if (baseline) {
+        int regressions = compare_baseline(baseline, tolerance);
+        if (regressions != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "bloom.h"
+#include "h160file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#define BLOOM_KEY_SIZE 20
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+    return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// splitmix64 的終結步驟
+static inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/*
+ * 由鍵的全部 20 字節算出塊號所用的 h 和塊內位置所用的 g。
+ * 不能直接使用鍵的字節：例如 zcash 地址的負載錯位一個字節，解碼出的值都以 0xb8 開頭。
+ */
+static inline void key_hash(const uint8_t *key, uint64_t *h, uint64_t *g)
+{
+    uint64_t a = get_le64(key), b = get_le64(key + 8), c = get_le32(key + 16);
+    *h = mix64(a ^ mix64(b ^ (c << 32 | c)));
+    *g = mix64(*h ^ b);
+}
+
+// 把鍵的 k 個位合成為塊內 8 個字的掩碼：g 每 9 位給出一個位置，用完 7 個後再混合一次
+static inline void block_mask(uint64_t g, uint32_t k, uint64_t mask[BLOOM_BLOCK_WORDS])
+{
+    memset(mask, 0, BLOOM_BLOCK_WORDS * sizeof(uint64_t));
+    for (uint32_t j = 0; j < k; j++) {
+        if (j > 0 && j % 7 == 0)
+            g = mix64(g);
+        uint32_t bit = (uint32_t)(g >> (9 * (j % 7))) & (BLOOM_BLOCK_BITS - 1);
+        mask[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+static inline uint64_t *block_of(const Bloom *b, uint64_t h)
+{
+    uint64_t idx = (uint64_t)(((unsigned __int128)h * b->block_count) >> 64);
+    return b->words + idx * BLOOM_BLOCK_WORDS;
+}
+
+/*
+ * 分塊布隆過濾器的誤判率：每塊的鍵數服從均值 lambda = 每塊位數 / 每鍵位數 的泊松分佈，
+ * 負載為 i 的塊誤判率為 (1 - (1 - 1/512)^(k*i))^k，按泊松概率加權求和。
+ */
+static double blocked_fpr(double lambda, int k)
+{
+    double p = exp(-lambda);      // P(load = 0)
+    double sum = 0.0;
+    int limit = (int)(lambda + 12.0 * sqrt(lambda) + 32.0);
+    for (int i = 0; i <= limit; i++) {
+        if (i > 0)
+            p *= lambda / i;
+        double fill = 1.0 - pow(1.0 - 1.0 / BLOOM_BLOCK_BITS, (double)k * i);
+        sum += p * pow(fill, k);
+    }
+    return sum;
+}
+
+/*
+ * 從普通布隆過濾器的 m/n = -ln(p) / ln(2)^2 開始，每次增加 5% 的位數，
+ * 直到某個 k 使 blocked_fpr 不超過目標；分塊帶來的額外位數在目標誤判率越低時越多。
+ */
+static void choose_size(double fpr, double *bits_per_key, int *k_out)
+{
+    double bpk = -log(fpr) / (M_LN2 * M_LN2);
+    for (int iter = 0; iter < 200; iter++, bpk *= 1.05) {
+        double lambda = BLOOM_BLOCK_BITS / bpk;
+        for (int k = 1; k <= BLOOM_MAX_K; k++) {
+            if (blocked_fpr(lambda, k) <= fpr) {
+                *bits_per_key = bpk;
+                *k_out = k;
+                return;
+            }
+        }
+    }
+    *bits_per_key = bpk;
+    *k_out = BLOOM_MAX_K;
+}
+
+int bloom_init(Bloom *b, uint64_t key_count, double fpr)
+{
+    memset(b, 0, sizeof(*b));
+    if (!(fpr > 0.0 && fpr < 1.0))
+        return -1;
+
+    double bits_per_key;
+    int k;
+    choose_size(fpr, &bits_per_key, &k);
+    double bits = bits_per_key * (double)(key_count ? key_count : 1);
+    uint64_t blocks = (uint64_t)ceil(bits / BLOOM_BLOCK_BITS);
+    if (blocks == 0)
+        blocks = 1;
+
+    size_t size = (size_t)blocks * (BLOOM_BLOCK_BITS / 8);
+    if (size / (BLOOM_BLOCK_BITS / 8) != blocks)
+        return -1;
+    void *mem = aligned_alloc(64, size);
+    if (!mem)
+        return -1;
+    memset(mem, 0, size);
+
+    b->words = (uint64_t *)mem;
+    b->block_count = blocks;
+    b->k = (uint32_t)k;
+    b->key_count = key_count;
+    b->base = mem;
+    b->size = size;
+    return 0;
+}
+
+void bloom_add_keys(Bloom *b, const uint8_t *keys, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *key = keys + i * BLOOM_KEY_SIZE;
+        uint64_t h, g;
+        key_hash(key, &h, &g);
+        uint64_t *blk = block_of(b, h);
+
+        // 先在本地合成整塊的位，再按字置位，每個字最多一次原子操作
+        uint64_t bits[BLOOM_BLOCK_WORDS];
+        block_mask(g, b->k, bits);
+        for (int w = 0; w < BLOOM_BLOCK_WORDS; w++) {
+            if (bits[w] && (blk[w] & bits[w]) != bits[w])
+                __atomic_fetch_or(&blk[w], bits[w], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+int bloom_contains(const Bloom *b, const uint8_t *key)
+{
+    uint64_t h, g;
+    key_hash(key, &h, &g);
+    const uint64_t *blk = block_of(b, h);
+    uint64_t bits[BLOOM_BLOCK_WORDS];
+    block_mask(g, b->k, bits);
+    for (int w = 0; w < BLOOM_BLOCK_WORDS; w++) {
+        if ((blk[w] & bits[w]) != bits[w])
+            return 0;
+    }
+    return 1;
+}
+
+int bloom_write(const Bloom *b, FILE *fp)
+{
+    uint8_t header[BLOOM_HEADER_SIZE] = {0};
+    memcpy(header, BLOOM_MAGIC, sizeof(BLOOM_MAGIC));
+    put_le32(header + 8, BLOOM_VERSION);
+    put_le32(header + 12, BLOOM_BLOCK_BITS);
+    put_le64(header + 16, b->block_count);
+    put_le32(header + 24, b->k);
+    put_le32(header + 28, BLOOM_KEY_SIZE);
+    put_le64(header + 32, b->key_count);
+    if (fwrite(header, 1, sizeof(header), fp) != sizeof(header))
+        return -1;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    size_t bytes = (size_t)b->block_count * (BLOOM_BLOCK_BITS / 8);
+    return fwrite(b->words, 1, bytes, fp) == bytes ? 0 : -1;
+#else
+    uint8_t buf[8];
+    for (uint64_t i = 0; i < b->block_count * BLOOM_BLOCK_WORDS; i++) {
+        put_le64(buf, b->words[i]);
+        if (fwrite(buf, 1, 8, fp) != 8)
+            return -1;
+    }
+    return 0;
+#endif
+}
+
+int bloom_open(const char *path, Bloom *b)
+{
+    memset(b, 0, sizeof(*b));
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    (void)path;
+    errno = ENOTSUP;
+    return -1;
+#else
+    void *base;
+    size_t size;
+    int is_mapped;
+    if (h160_map_file(path, &base, &size, &is_mapped) != 0)
+        return -1;
+
+    const uint8_t *p = (const uint8_t *)base;
+    uint64_t blocks = size >= BLOOM_HEADER_SIZE ? get_le64(p + 16) : 0;
+    uint32_t k = size >= BLOOM_HEADER_SIZE ? get_le32(p + 24) : 0;
+    if (size < BLOOM_HEADER_SIZE || memcmp(p, BLOOM_MAGIC, sizeof(BLOOM_MAGIC)) != 0 ||
+        get_le32(p + 8) != BLOOM_VERSION || get_le32(p + 12) != BLOOM_BLOCK_BITS ||
+        get_le32(p + 28) != BLOOM_KEY_SIZE || k < 1 || k > BLOOM_MAX_K || blocks == 0 ||
+        blocks > (size - BLOOM_HEADER_SIZE) / (BLOOM_BLOCK_BITS / 8) ||
+        BLOOM_HEADER_SIZE + blocks * (BLOOM_BLOCK_BITS / 8) != size) {
+        h160_unmap_file(base, size, is_mapped);
+        errno = EINVAL;
+        return -1;
+    }
+
+    // 塊數據按小端 64 位字存放，可直接使用映射
+    b->words = (uint64_t *)(void *)(p + BLOOM_HEADER_SIZE);
+    b->block_count = blocks;
+    b->k = k;
+    b->key_count = get_le64(p + 32);
+    b->base = base;
+    b->size = size;
+    b->is_mapped = is_mapped;
+    return 0;
+#endif
+}
+
+void bloom_free(Bloom *b)
+{
+    // bloom_init 分配的位數組從 base 開始；映射的文件在 base 之後還有文件頭
+    if (b->base == (void *)b->words)
+        free(b->base);
+    else
+        h160_unmap_file(b->base, b->size, b->is_mapped);
+    memset(b, 0, sizeof(*b));
+}
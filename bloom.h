@@ -0,0 +1,81 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * hash160 的分塊布隆過濾器：每個鍵只落在一個 64 字節（512 位）的塊中，一次查詢只訪問一條緩存行。
+ * 鍵的 20 字節按小端讀作 a = key[0..8)、b = key[8..16)、c = key[16..20)（32 位），
+ * mix64 為 splitmix64 的終結步驟（x ^= x >> 30; x *= 0xbf58476d1ce4e5b9;
+ * x ^= x >> 27; x *= 0x94d049bb133111eb; x ^= x >> 31）：
+ *
+ *   h      = mix64(a ^ mix64(b ^ (c << 32 | c)))
+ *   g      = mix64(h ^ b)
+ *   塊號   = (h × 塊數) >> 64（128 位乘法取高 64 位）
+ *   第 i 位 = (g_i >> (9 × (i mod 7))) & 511，i = 0 .. k-1；
+ *            g_0 = g，每用完 7 個位置再混合一次：g_{i} = mix64(g_{i-1})（i 為 7 的倍數時）
+ *
+ * .bloom 文件佈局（所有整數均為小端序）：
+ *
+ *   偏移  長度  內容
+ *   0     8     魔數 "H160BLM\0"
+ *   8     4     版本號，當前為 1
+ *   12    4     每塊位數，當前為 512
+ *   16    8     塊數
+ *   24    4     每個鍵設置的位數 k
+ *   28    4     鍵寬度（字節），hash160 為 20
+ *   32    8     插入的鍵數
+ *   40    24    保留，寫 0
+ *   64    ...   塊數 × 64 字節；每塊為 8 個小端 64 位字，第 j 位位於第 j / 64 個字的第 j % 64 位
+ *
+ * 文件頭為 64 字節，映射後各塊按緩存行對齊。文件大小恰好為 64 + 塊數 × 64。
+ */
+#define BLOOM_MAGIC        "H160BLM"
+#define BLOOM_VERSION      1
+#define BLOOM_HEADER_SIZE  64
+#define BLOOM_BLOCK_BITS   512
+#define BLOOM_BLOCK_WORDS  (BLOOM_BLOCK_BITS / 64)
+#define BLOOM_MAX_K        16
+
+typedef struct {
+    uint64_t *words;           // 塊數 × 8 個字
+    uint64_t block_count;
+    uint32_t k;
+    uint64_t key_count;
+    void *base;                // 分配或映射的內存
+    size_t size;
+    int is_mapped;             // 1 表示來自 h160_map_file，0 表示來自 bloom_init
+} Bloom;
+
+// 按鍵數和目標誤判率（0 < fpr < 1）選擇塊數與 k，並分配清零的位數組。返回 0 表示成功，-1 表示參數無效或內存不足。
+int bloom_init(Bloom *b, uint64_t key_count, double fpr);
+
+// 插入 n 個連續存放的 20 字節鍵。不同線程可並發插入（按字原子置位）。
+void bloom_add_keys(Bloom *b, const uint8_t *keys, size_t n);
+
+// 返回 1 表示可能存在，0 表示一定不存在
+int bloom_contains(const Bloom *b, const uint8_t *key);
+
+// 寫出文件頭和全部塊。返回 0 表示成功，-1 表示寫入失敗。
+int bloom_write(const Bloom *b, FILE *fp);
+
+// 映射並校驗 .bloom 文件（僅限小端平台）。返回 0 表示成功；-1 表示失敗，errno 保存原因（格式不符時為 EINVAL）。
+int bloom_open(const char *path, Bloom *b);
+
+// 釋放位數組或解除映射
+void bloom_free(Bloom *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLOOM_H
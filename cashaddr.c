@@ -3,6 +3,8 @@
  * Assist in creation ：ChatGPT
  */
 #include "cashaddr.h"
+#include "polymod.h"
+#include "hex.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,33 +14,28 @@
 /* CashAddr中使用的Base32字符集 */
 static const char *CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
 
+/* 字符集反查表：ASCII 字符 -> 5 位值，大小写均可，-1 表示不在字符集中 */
+static const int8_t CHARSET_REV[128] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+    -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+     1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
+    -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+     1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
+};
+
 /* 内部函数声明 */
-static uint64_t _polymod(const int *values, size_t count);
 static void _calculate_checksum(const char *prefix, const int *payload, int payload_len, int checksum[8]);
 static int _pack_5bit(const unsigned char *data, int data_len, int *out, int max_out);
-static int _unpack_5bit(const int *data, int data_len, unsigned char *out, int max_out);
-
-/* 多项式模运算，用于校验和计算 */
-static uint64_t _polymod(const int *values, size_t count) {
-    uint64_t c = 1;
-    for (size_t i = 0; i < count; i++) {
-        int d = values[i];
-        int c0 = (int)(c >> 35);
-        c = ((c & 0x07ffffffffULL) << 5) ^ d;
-        if (c0 & 0x01) c ^= 0x98f2bc8e61ULL;
-        if (c0 & 0x02) c ^= 0x79b76d99e2ULL;
-        if (c0 & 0x04) c ^= 0xf33e5fb3c4ULL;
-        if (c0 & 0x08) c ^= 0xae2eabe2a8ULL;
-        if (c0 & 0x10) c ^= 0x1e4f43e470ULL;
-    }
-    return c ^ 1;
-}
+static int _unpack_5bit(const uint8_t *data, int data_len, unsigned char *out, int max_out);
 
 /* 计算CashAddr的校验和 */
 static void _calculate_checksum(const char *prefix, const int *payload, int payload_len, int checksum[8]) {
     int prefix_len = (int)strlen(prefix);
     int data_len = prefix_len + 1 + payload_len + 8;
-    int *data = (int *)malloc(data_len * sizeof(int));
+    uint8_t *data = (uint8_t *)malloc(data_len);
     if (!data) {
         //fprintf(stderr, "内存分配失败\n"); // 修改：注释掉内存分配失败的错误报告
         exit(1);
@@ -56,7 +53,7 @@ static void _calculate_checksum(const char *prefix, const int *payload, int payl
     for (int i = prefix_len + 1 + payload_len; i < data_len; i++) {
         data[i] = 0;
     }
-    uint64_t poly = _polymod(data, data_len);
+    uint64_t poly = cashaddr_polymod(data, data_len) ^ 1;
     free(data);
     for (int i = 0; i < 8; i++) {
         checksum[i] = (poly >> (5 * (7 - i))) & 0x1f;
@@ -85,7 +82,7 @@ static int _pack_5bit(const unsigned char *data, int data_len, int *out, int max
 }
 
 /* 将5位数组还原为字节数组，返回还原后的字节数 */
-static int _unpack_5bit(const int *data, int data_len, unsigned char *out, int max_out) {
+static int _unpack_5bit(const uint8_t *data, int data_len, unsigned char *out, int max_out) {
     int buffer = 0, bits = 0;
     int count = 0;
     for (int i = 0; i < data_len; i++) {
@@ -101,111 +98,98 @@ static int _unpack_5bit(const int *data, int data_len, unsigned char *out, int m
     return count;
 }
 
-/* 解码现金地址，结果写入result结构中，返回0表示成功 */
-int decode_cashaddr(const char *address, CashAddrResult *result) {
-    char prefix[32] = {0};
+/* 解析现金地址但不校验：前缀与 Base32 部分写入 parsed->values（polymod 的输入），不分配内存。
+ * 返回 0 表示成功，-1 表示失败
+ */
+int cashaddr_parse(const char *address, size_t len, CashAddrParsed *parsed) {
     const char *base32_part = NULL;
-    char *colon = strchr(address, ':');
+    const char *colon = (const char *)memchr(address, ':', len);
     if (colon) {
         size_t pre_len = colon - address;
-        if (pre_len >= sizeof(prefix)) {
-            //fprintf(stderr, "前缀过长\n"); // 修改：注释掉前缀过长的错误报告
-            return -1;
+        if (pre_len > CASHADDR_PREFIX_MAX) {
+            return -1;  /* 前缀过长 */
         }
-        strncpy(prefix, address, pre_len);
-        prefix[pre_len] = '\0';
+        memcpy(parsed->prefix, address, pre_len);
+        parsed->prefix[pre_len] = '\0';
+        parsed->prefix_len = pre_len;
         base32_part = colon + 1;
     } else {
-        strcpy(prefix, "bitcoincash");
+        strcpy(parsed->prefix, "bitcoincash");
+        parsed->prefix_len = 11;
         base32_part = address;
     }
-    //printf("[调试] 前缀: %s\n", prefix); // 这些调试语句之前已经注释掉了，无需再次修改
-    //printf("[调试] Base32部分: %s\n", base32_part);
 
-    int base32_len = (int)strlen(base32_part);
-    int *packed = (int *)malloc(base32_len * sizeof(int));
-    if (!packed) {
-        //fprintf(stderr, "内存分配失败\n"); // 修改：注释掉内存分配失败的错误报告
-        return -1;
-    }
-    // 将base32字符转换为5位数组
-    for (int i = 0; i < base32_len; i++) {
-        char ch = tolower(base32_part[i]);
-        const char *p = strchr(CHARSET, ch);
-        if (!p) {
-            //fprintf(stderr, "无效字符 '%c'\n", ch); // 修改：注释掉无效字符的错误报告
-            free(packed);
-            return -1;
-        }
-        packed[i] = (int)(p - CHARSET);
-    }
-    //printf("[调试] 5位数组 (packed): [");
-    for (int i = 0; i < base32_len; i++) {
-        //printf("%d%s", packed[i], i == base32_len - 1 ? "" : ", ");
+    /* 前缀：每个字符取小写后的低5位，之后接一个 0 */
+    size_t n = 0;
+    for (size_t i = 0; i < parsed->prefix_len; i++) {
+        parsed->values[n++] = tolower((unsigned char)parsed->prefix[i]) & 0x1f;
     }
-    //printf("]\n");
+    parsed->values[n++] = 0;
 
-    if (base32_len < 8) {
-        //fprintf(stderr, "地址过短\n"); // 修改：注释掉地址过短的错误报告
-        free(packed);
+    /* 将base32字符转换为5位数组；至少 8 个校验值，payload 解包后不超过 100 字节 */
+    size_t base32_len = len - (size_t)(base32_part - address);
+    if (base32_len < 8 || base32_len > CASHADDR_DATA_MAX) {
         return -1;
     }
-    int payload_len = base32_len - 8;
-    int *payload_packed = packed; // 前payload_len个数为有效载荷
-    //int *checksum_extracted = packed + payload_len; // 此行之前有警告，但不是打印语句
-    //printf("[调试] 有效载荷 (payload_packed): [");
-    for (int i = 0; i < payload_len; i++) {
-        //printf("%d%s", payload_packed[i], i == payload_len - 1 ? "" : ", ");
+    for (size_t i = 0; i < base32_len; i++) {
+        unsigned char ch = (unsigned char)base32_part[i];
+        int8_t v = ch < 128 ? CHARSET_REV[ch] : -1;
+        if (v < 0) {
+            return -1;  /* 无效字符 */
+        }
+        parsed->values[n++] = (uint8_t)v;
     }
-    //printf("]\n");
-    //printf("[调试] 提取的校验和: [");
-    for (int i = 0; i < 8; i++) {
-        //printf("%d%s", checksum_extracted[i], i == 7 ? "" : ", ");
+    parsed->values_len = n;
+    return 0;
+}
+
+/* 校验 polymod 并把 payload 解包为字节（版本字节 + 哈希），返回字节数，失败返回 -1 */
+static int _unpack_payload(const CashAddrParsed *parsed, uint64_t polymod, unsigned char payload_bytes[100]) {
+    if (polymod != 1) {
+        return -1;  /* 校验和无效 */
+    }
+    const uint8_t *payload_packed = parsed->values + parsed->prefix_len + 1;
+    int payload_len = (int)(parsed->values_len - parsed->prefix_len - 1) - 8;
+    int payload_bytes_len = _unpack_5bit(payload_packed, payload_len, payload_bytes, 100);
+    if (payload_bytes_len < 1) {
+        return -1;  /* 无效payload */
     }
-    //printf("]\n");
+    return payload_bytes_len;
+}
 
-    // 构造用于校验和计算的数据数组
-    int prefix_len = (int)strlen(prefix);
-    int data_len = prefix_len + 1 + base32_len;
-    int *data = (int *)malloc(data_len * sizeof(int));
-    if (!data) {
-        //fprintf(stderr, "内存分配失败\n"); // 修改：注释掉内存分配失败的错误报告
-        free(packed);
+/* 由解析结果及其 polymod 值完成解码，只写入版本字节和原始哈希，返回0表示成功 */
+int decode_cashaddr_parsed_bin(const CashAddrParsed *parsed, uint64_t polymod,
+                               uint8_t *version_byte, uint8_t *hash, size_t *hash_len) {
+    /* 版本字节低 3 位为哈希长度：160、192、224、256、320、384、448、512 位 */
+    static const uint8_t HASH_SIZES[8] = {20, 24, 28, 32, 40, 48, 56, 64};
+    unsigned char payload_bytes[100];
+    int payload_bytes_len = _unpack_payload(parsed, polymod, payload_bytes);
+    if (payload_bytes_len < 0) {
         return -1;
     }
-    for (int i = 0; i < prefix_len; i++) {
-        data[i] = tolower(prefix[i]) & 0x1f;
-    }
-    data[prefix_len] = 0;
-    memcpy(data + prefix_len + 1, packed, base32_len * sizeof(int));
-    uint64_t poly = _polymod(data, data_len);
-    free(data);
-    //printf("[调试] 多项式模运算结果: %llu\n", (unsigned long long)poly);
-    if (poly != 0) {
-        //fprintf(stderr, "校验和无效\n"); // 修改：注释掉校验和无效的错误报告
-        free(packed);
-        return -1;
+    size_t size = HASH_SIZES[payload_bytes[0] & 0x07];
+    if ((size_t)payload_bytes_len != size + 1 || *hash_len < size) {
+        return -1;  /* 哈希长度与版本字节不符，或缓冲区不足 */
     }
+    *version_byte = payload_bytes[0];
+    memcpy(hash, payload_bytes + 1, size);
+    *hash_len = size;
+    return 0;
+}
 
+/* 由解析结果及其 polymod 值完成解码，结果写入result结构中，返回0表示成功 */
+int decode_cashaddr_parsed(const CashAddrParsed *parsed, uint64_t polymod, CashAddrResult *result) {
     // 解包有效载荷（转换为字节数组）
     unsigned char payload_bytes[100] = {0};
-    int payload_bytes_len = _unpack_5bit(payload_packed, payload_len, payload_bytes, sizeof(payload_bytes));
-    if (payload_bytes_len < 1) {
-        //fprintf(stderr, "无效payload\n"); // 修改：注释掉无效payload的错误报告
-        free(packed);
+    int payload_bytes_len = _unpack_payload(parsed, polymod, payload_bytes);
+    if (payload_bytes_len < 0) {
         return -1;
     }
-    //printf("[调试] 解包后的有效载荷字节: [");
-    for (int i = 0; i < payload_bytes_len; i++) {
-        //printf("%d%s", payload_bytes[i], i == payload_bytes_len - 1 ? "" : ", ");
-    }
-    //printf("]\n");
 
     // 解析版本字节
     int version_byte = payload_bytes[0];
     int version = version_byte & 0x07;
     int type_bits = (version_byte >> 3) & 0x1f;
-    //printf("[调试] 版本字节: %d, 版本: %d, 类型位: %d\n", version_byte, version, type_bits);
 
     char addr_type[16] = {0};
     if (type_bits == 0) {
@@ -218,52 +202,39 @@ int decode_cashaddr(const char *address, CashAddrResult *result) {
 
     // 提取hash160：payload_bytes[1..20]
     if (payload_bytes_len < 21) {
-        //fprintf(stderr, "payload长度不足\n"); // 修改：注释掉payload长度不足的错误报告
-        free(packed);
-        return -1;
-    }
-    char hash160_hex[41] = {0};
-    for (int i = 0; i < 20; i++) {
-        sprintf(hash160_hex + i * 2, "%02x", payload_bytes[i+1]);
+        return -1;  /* payload长度不足 */
     }
+    char hash160_hex[41];
+    hex_encode(payload_bytes + 1, 20, hash160_hex);
 
     /* 填充返回结果 */
-    strncpy(result->prefix, prefix, sizeof(result->prefix)-1);
+    strncpy(result->prefix, parsed->prefix, sizeof(result->prefix)-1);
     result->prefix[sizeof(result->prefix)-1] = '\0'; // 确保 null 终止
     result->version = version;
     strncpy(result->type, addr_type, sizeof(result->type)-1);
     result->type[sizeof(result->type)-1] = '\0'; // 确保 null 终止
     strncpy(result->hash160, hash160_hex, sizeof(result->hash160)-1);
     result->hash160[sizeof(result->hash160)-1] = '\0'; // 确保 null 终止
-
-
-    free(packed);
     return 0;
 }
 
-/* 将一个十六进制字符转换为数字 */
-static int hexchar2int(char c) {
-    if ('0' <= c && c <= '9')
-        return c - '0';
-    c = tolower(c);
-    if ('a' <= c && c <= 'f')
-        return c - 'a' + 10;
-    return -1;
+/* 解码现金地址，结果写入result结构中，返回0表示成功 */
+int decode_cashaddr(const char *address, CashAddrResult *result) {
+    CashAddrParsed parsed;
+    if (cashaddr_parse(address, strlen(address), &parsed) != 0) {
+        return -1;
+    }
+    return decode_cashaddr_parsed(&parsed, cashaddr_polymod(parsed.values, parsed.values_len), result);
 }
 
-/* 将十六进制字符串转换为字节数组，返回字节数 */
-static int hexstr2bytes(const char *hex, unsigned char *out, int max_out) {
-    int len = (int)strlen(hex);
-    if (len % 2 != 0) return -1;
-    int bytes = len / 2;
-    if (bytes > max_out) return -1;
-    for (int i = 0; i < bytes; i++) {
-        int hi = hexchar2int(hex[2*i]);
-        int lo = hexchar2int(hex[2*i+1]);
-        if (hi < 0 || lo < 0) return -1;
-        out[i] = (unsigned char)((hi << 4) | lo);
+/* 解码现金地址为二进制：版本字节与 20～64 字节的原始哈希，不分配内存，返回0表示成功 */
+int decode_cashaddr_bin(const char *address, uint8_t *version_byte, uint8_t *hash, size_t *hash_len) {
+    CashAddrParsed parsed;
+    if (cashaddr_parse(address, strlen(address), &parsed) != 0) {
+        return -1;
     }
-    return bytes;
+    return decode_cashaddr_parsed_bin(&parsed, cashaddr_polymod(parsed.values, parsed.values_len),
+                                      version_byte, hash, hash_len);
 }
 
 /* 编码现金地址，结果写入out_address中 */
@@ -280,7 +251,7 @@ int encode_cashaddr(const char *prefix, int version, const char *type, const cha
     }
     int version_byte = (type_bits << 3) | (version & 0x07);
     unsigned char hash_bytes[20];
-    if (hexstr2bytes(hash160, hash_bytes, sizeof(hash_bytes)) != 20) {
+    if (hex_decode(hash160, strlen(hash160), hash_bytes, sizeof(hash_bytes)) != 20) {
         //fprintf(stderr, "无效的hash160\n"); // 修改：注释掉无效hash160的错误报告
         return -1;
     }
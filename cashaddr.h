@@ -15,6 +15,31 @@ typedef struct {
     char hash160[41];    /* 40字符十六进制字符串，附带结束符 */
 } CashAddrResult;
 
+/* 前缀最大长度 */
+#define CASHADDR_PREFIX_MAX 31
+/* Base32 部分的最大长度（含 8 个校验值）：payload 解包后最多 100 字节 */
+#define CASHADDR_DATA_MAX 169
+/* polymod 输入的最大长度：前缀 + 分隔用的 0 + Base32 部分 */
+#define CASHADDR_VALUES_MAX (CASHADDR_PREFIX_MAX + 1 + CASHADDR_DATA_MAX)
+
+/* 解析后、校验前的现金地址 */
+typedef struct {
+    char prefix[CASHADDR_PREFIX_MAX + 1];
+    size_t prefix_len;
+    uint8_t values[CASHADDR_VALUES_MAX];   /* polymod 的输入：前缀低 5 位、0、Base32 部分的 5 位值 */
+    size_t values_len;
+} CashAddrParsed;
+
+/* 解析现金地址 address[0..len)（不要求以 '\0' 结尾）但不校验，用于把多个地址的校验和交给 cashaddr_polymod_batch 一起计算
+ * 返回 0 表示成功，-1 表示失败
+ */
+int cashaddr_parse(const char *address, size_t len, CashAddrParsed *parsed);
+
+/* 由 cashaddr_parse 的结果及其 polymod 值（cashaddr_polymod(parsed->values, parsed->values_len)）完成解码
+ * 返回 0 表示成功，-1 表示失败
+ */
+int decode_cashaddr_parsed(const CashAddrParsed *parsed, uint64_t polymod, CashAddrResult *result);
+
 /* 解码现金地址
  * 参数 address：输入地址字符串
  * 参数 result：输出解析结果（注意：需要保证结构体指针有效）
@@ -22,6 +47,19 @@ typedef struct {
  */
 int decode_cashaddr(const char *address, CashAddrResult *result);
 
+/* 解码现金地址为二进制，不分配内存、不经过十六进制字符串
+ * 参数 address：输入地址字符串
+ * 参数 version_byte：输出版本字节（高 5 位为类型，低 3 位为哈希长度）
+ * 参数 hash：输出原始哈希（20、24、28、32、40、48、56 或 64 字节）
+ * 参数 hash_len：输入时为 hash 缓冲区大小，输出时为哈希长度
+ * 返回 0 表示成功，-1 表示失败（含哈希长度与版本字节不符）
+ */
+int decode_cashaddr_bin(const char *address, uint8_t *version_byte, uint8_t *hash, size_t *hash_len);
+
+/* 同 decode_cashaddr_bin，输入为 cashaddr_parse 的结果及其 polymod 值 */
+int decode_cashaddr_parsed_bin(const CashAddrParsed *parsed, uint64_t polymod,
+                               uint8_t *version_byte, uint8_t *hash, size_t *hash_len);
+
 /* 编码现金地址
  * 参数 prefix：地址前缀
  * 参数 version：版本号（0-7）
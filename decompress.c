@@ -0,0 +1,817 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "decompress.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+static uint32_t read_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+size_t decompress_zstd_frame_size(const void *data, size_t avail)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    if (avail < 8)
+        return 0;
+    uint32_t magic = read_le32(p);
+    if ((magic & 0xfffffff0u) == 0x184d2a50u) {
+        size_t size = 8 + (size_t)read_le32(p + 4);
+        return size <= avail ? size : 0;
+    }
+    if (magic != 0xfd2fb528u)
+        return 0;
+
+    unsigned fhd = p[4];
+    if (fhd & 0x08)
+        return 0;   // 保留位必須為 0
+    static const size_t dict_id_size[4] = {0, 1, 2, 4};
+    static const size_t content_size_size[4] = {0, 2, 4, 8};
+    int single_segment = (fhd >> 5) & 1;
+    size_t pos = 5 + (single_segment ? 0 : 1) + dict_id_size[fhd & 3] + content_size_size[fhd >> 6];
+    if ((fhd >> 6) == 0 && single_segment)
+        pos += 1;
+
+    for (;;) {
+        if (pos + 3 > avail)
+            return 0;
+        uint32_t header = (uint32_t)p[pos] | (uint32_t)p[pos + 1] << 8 | (uint32_t)p[pos + 2] << 16;
+        unsigned type = (header >> 1) & 3;
+        if (type == 3)
+            return 0;
+        pos += 3 + (type == 1 ? 1 : (size_t)(header >> 3));   // RLE 塊只存一個字節
+        if (pos > avail)
+            return 0;
+        if (header & 1)
+            break;
+    }
+    if (fhd & 0x04)
+        pos += 4;   // 內容校驗和
+    return pos <= avail ? pos : 0;
+}
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <zlib.h>
+
+// 解壓線程每次讀入和寫出的字節數
+#define DECOMPRESS_BUF_SIZE (1u << 20)
+
+// 並行解壓 zstd 時一段的最小壓縮數據量，更小的文件交給單個 zstd 進程
+#define ZSTD_MIN_RANGE_BYTES (1u << 20)
+
+// 估計的壓縮比：一段的壓縮數據量取其輸出額度的 1/4，解壓結果大致能放進額度，各段不必互相等待
+#define ZSTD_RATIO_GUESS 4
+
+// 並行解壓時子進程輸出按此大小分塊排隊
+#define ZSTD_BLOCK_BYTES (256u << 10)
+
+// 一段連續的 zstd 幀，由一個 zstd 子進程解壓；輸出按塊排隊，等輪到它時按順序寫入管道
+struct ZstdBlock {
+    struct ZstdBlock *next;
+    size_t len;
+    unsigned char data[];
+};
+
+struct ZstdRange {
+    struct ZstdParallel *par;
+    size_t start;                // 在文件映射中的偏移
+    size_t len;
+    struct ZstdBlock *head;      // 已解壓、等待寫出的塊
+    struct ZstdBlock *tail;
+    size_t buffered;             // 隊列中的字節數，不超過 par->range_budget
+    int done;
+    int error;
+    pthread_t thread;
+};
+
+// 並行解壓的共享狀態，各段的隊列都由 lock 保護
+struct ZstdParallel {
+    Decompressor *d;
+    struct ZstdRange *ranges;
+    size_t count;
+    size_t range_budget;         // 每段可排隊的解壓結果字節數
+    int stop;                    // 下游已關閉或出錯，各段線程盡快退出
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+// 帶 close-on-exec 的管道，並行啟動的子進程不會繼承彼此的管道端
+static int cloexec_pipe(int fds[2])
+{
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC);
+#else
+    if (pipe(fds) != 0)
+        return -1;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+
+/*
+ * 用 posix_spawnp 啟動 zstd -dcq [-- path]，標準輸入接 in_fd（-1 表示讀 path），標準輸出接 out_fd。
+ * 管道都帶 close-on-exec，子進程只保留 dup2 得到的兩端。子進程的信號屏蔽字清空、SIGPIPE 恢復默認，
+ * 不受調用線程屏蔽 SIGPIPE 的影響，讀端提前關閉時它會正常結束。
+ * 返回 0 表示成功，否則返回錯誤碼（找不到 zstd 時為 ENOENT）。
+ */
+static int spawn_zstd(const char *path, int in_fd, int out_fd, pid_t *pid)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    int ret = posix_spawn_file_actions_init(&actions);
+    if (ret != 0)
+        return ret;
+    ret = posix_spawnattr_init(&attr);
+    if (ret != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return ret;
+    }
+
+    sigset_t empty, pipe_only;
+    sigemptyset(&empty);
+    sigemptyset(&pipe_only);
+    sigaddset(&pipe_only, SIGPIPE);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setsigdefault(&attr, &pipe_only);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    if (in_fd >= 0)
+        ret = posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    if (ret == 0)
+        ret = posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+
+    if (ret == 0) {
+        char *argv[] = {(char *)"zstd", (char *)"-dcq", (char *)"--", (char *)path, NULL};
+        if (!path)
+            argv[2] = NULL;
+        ret = posix_spawnp(pid, "zstd", &actions, &attr, argv, environ);
+    }
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return ret;
+}
+
+// 子進程的退出狀態轉為 errno：0 表示正常，EIO 表示解壓失敗
+static int child_status_error(int status)
+{
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : EIO;
+}
+
+// 寫完整個緩衝區。返回 -1 表示下游已關閉管道或寫入失敗
+static int write_all(int fd, const unsigned char *p, size_t n)
+{
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+/*
+ * 啟動輔助線程（解壓、轉發、並行解壓）。線程在 SIGPIPE 被屏蔽的狀態下創建，
+ * 下游提前關閉管道時寫入得到 EPIPE，而進程本身對 SIGPIPE 的處理保持不變。
+ */
+static int start_thread(pthread_t *thread, void *(*fn)(void *), void *arg)
+{
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    int ret = pthread_create(thread, NULL, fn, arg);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return ret;
+}
+
+// 管道默認只有 64K，調大可減少解壓線程與讀取線程之間的切換
+static void enlarge_pipe(int fd)
+{
+#ifdef F_SETPIPE_SZ
+    fcntl(fd, F_SETPIPE_SZ, (int)DECOMPRESS_BUF_SIZE);
+#else
+    (void)fd;
+#endif
+}
+
+/*
+ * gzip 解壓線程：src → inflate → 管道。
+ * 一個成員結束後若還有以 0x1f 開頭的數據則繼續解壓下一個成員（pigz、bgzip 及 cat 拼接的文件），
+ * 成員之後的其他數據按 gzip 的慣例忽略。
+ */
+static void *gzip_thread(void *arg)
+{
+    Decompressor *d = (Decompressor *)arg;
+    unsigned char *in = (unsigned char *)malloc(DECOMPRESS_BUF_SIZE);
+    unsigned char *out = (unsigned char *)malloc(DECOMPRESS_BUF_SIZE);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int eof = 0;
+
+    if (!in || !out || inflateInit2(&zs, 15 + 16) != Z_OK) {
+        d->error = ENOMEM;
+        free(in);
+        free(out);
+        close(d->pipe_out);
+        return NULL;
+    }
+
+    // 檢測格式時已從不可回退的輸入讀走的字節
+    memcpy(in, d->prefix, d->prefix_len);
+    zs.next_in = in;
+    zs.avail_in = (uInt)d->prefix_len;
+
+    for (;;) {
+        if (zs.avail_in == 0 && !eof) {
+            size_t n = fread(in, 1, DECOMPRESS_BUF_SIZE, d->src);
+            if (n == 0) {
+                if (ferror(d->src)) {
+                    d->error = EIO;
+                    break;
+                }
+                eof = 1;
+            }
+            zs.next_in = in;
+            zs.avail_in = (uInt)n;
+        }
+
+        zs.next_out = out;
+        zs.avail_out = DECOMPRESS_BUF_SIZE;
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            d->error = EIO;
+            break;
+        }
+        size_t have = DECOMPRESS_BUF_SIZE - zs.avail_out;
+        if (have > 0 && write_all(d->pipe_out, out, have) != 0)
+            break;
+
+        if (ret == Z_STREAM_END) {
+            if (zs.avail_in == 0 && !eof) {
+                size_t n = fread(in, 1, DECOMPRESS_BUF_SIZE, d->src);
+                if (n == 0 && ferror(d->src)) {
+                    d->error = EIO;
+                    break;
+                }
+                eof = n == 0;
+                zs.next_in = in;
+                zs.avail_in = (uInt)n;
+            }
+            if (zs.avail_in == 0 || zs.next_in[0] != 0x1f)
+                break;
+            inflateReset(&zs);
+        } else if (ret == Z_BUF_ERROR && eof && zs.avail_in == 0) {
+            d->error = EIO;   // 文件被截斷
+            break;
+        }
+    }
+
+    inflateEnd(&zs);
+    free(in);
+    free(out);
+    close(d->pipe_out);
+    return NULL;
+}
+
+// zstd 讀標準輸入時的轉發線程：src → zstd 子進程的標準輸入
+static void *zstd_feed_thread(void *arg)
+{
+    Decompressor *d = (Decompressor *)arg;
+    unsigned char *buf = (unsigned char *)malloc(DECOMPRESS_BUF_SIZE);
+    if (buf && write_all(d->pipe_in, d->prefix, d->prefix_len) == 0) {
+        size_t n;
+        while ((n = fread(buf, 1, DECOMPRESS_BUF_SIZE, d->src)) > 0) {
+            if (write_all(d->pipe_in, buf, n) != 0)
+                break;
+        }
+        if (ferror(d->src))
+            d->error = EIO;
+        free(buf);
+    } else if (!buf) {
+        d->error = ENOMEM;
+    }
+    close(d->pipe_in);
+    return NULL;
+}
+
+/*
+ * 啟動單個 zstd 子進程，標準輸出接到 out_fd。seekable 時子進程直接打開 path，
+ * 否則經由轉發線程讀取 src。找不到 zstd 時不啟動任何東西，記下 ENOENT，
+ * fp 立即讀到結尾，decompress_close 報告原因。
+ */
+static int start_zstd(Decompressor *d, int out_fd, int seekable)
+{
+    int in_pipe[2] = {-1, -1};
+    if (!seekable && cloexec_pipe(in_pipe) != 0)
+        return -1;
+
+    pid_t pid;
+    int err = spawn_zstd(seekable ? d->path : NULL, in_pipe[0], out_fd, &pid);
+    if (!seekable)
+        close(in_pipe[0]);
+    if (err != 0) {
+        if (!seekable)
+            close(in_pipe[1]);
+        if (err == ENOENT) {
+            d->error = ENOENT;
+            return 0;
+        }
+        errno = err;
+        return -1;
+    }
+
+    d->child = (int)pid;
+    if (!seekable) {
+        d->pipe_in = in_pipe[1];
+        if (start_thread(&d->thread, zstd_feed_thread, d) != 0) {
+            close(d->pipe_in);
+            return -1;
+        }
+        d->thread_started = 1;
+    }
+    return 0;
+}
+
+// 釋放並行解壓的狀態和文件映射
+static void free_parallel(Decompressor *d)
+{
+    struct ZstdParallel *par = d->parallel;
+    if (par) {
+        pthread_mutex_destroy(&par->lock);
+        pthread_cond_destroy(&par->cond);
+        free(par->ranges);
+        free(par);
+        d->parallel = NULL;
+    }
+    if (d->map) {
+        munmap(d->map, d->map_size);
+        d->map = NULL;
+    }
+}
+
+/*
+ * 把映射的文件按幀邊界切成若干段。每段約為文件的 1/workers，
+ * 但不超過一段輸出額度的 1/ZSTD_RATIO_GUESS，大文件因此切得更細，解壓結果不會在額度前堆積。
+ * 返回段數；無法識別的幀或只有一段時返回 0，由調用者退回單個 zstd 進程（它會報告具體的錯誤）。
+ */
+static size_t split_zstd_ranges(struct ZstdParallel *par)
+{
+    Decompressor *d = par->d;
+    const unsigned char *p = (const unsigned char *)d->map;
+    size_t target = d->map_size / (size_t)d->workers;
+    if (target > par->range_budget / ZSTD_RATIO_GUESS)
+        target = par->range_budget / ZSTD_RATIO_GUESS;
+    if (target < ZSTD_MIN_RANGE_BYTES)
+        target = ZSTD_MIN_RANGE_BYTES;
+
+    size_t cap = d->map_size / target + 2;
+    struct ZstdRange *ranges = (struct ZstdRange *)calloc(cap, sizeof(*ranges));
+    if (!ranges)
+        return 0;
+
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < d->map_size) {
+        size_t start = pos;
+        while (pos < d->map_size && pos - start < target) {
+            size_t n = decompress_zstd_frame_size(p + pos, d->map_size - pos);
+            if (n == 0) {
+                free(ranges);
+                return 0;
+            }
+            pos += n;
+        }
+        if (count == cap) {
+            cap *= 2;
+            struct ZstdRange *grown = (struct ZstdRange *)realloc(ranges, cap * sizeof(*ranges));
+            if (!grown) {
+                free(ranges);
+                return 0;
+            }
+            ranges = grown;
+        }
+        memset(&ranges[count], 0, sizeof(ranges[count]));
+        ranges[count].par = par;
+        ranges[count].start = start;
+        ranges[count].len = pos - start;
+        count++;
+    }
+    if (count < 2) {
+        free(ranges);
+        return 0;
+    }
+    par->ranges = ranges;
+    par->count = count;
+    return count;
+}
+
+// 把一塊解壓結果放入段的隊列，隊列已滿時等待協調線程取走
+static int queue_block(struct ZstdRange *r, struct ZstdBlock *block)
+{
+    struct ZstdParallel *par = r->par;
+    pthread_mutex_lock(&par->lock);
+    while (!par->stop && r->buffered > 0 && r->buffered + block->len > par->range_budget)
+        pthread_cond_wait(&par->cond, &par->lock);
+    int stop = par->stop;
+    if (!stop) {
+        block->next = NULL;
+        if (r->tail)
+            r->tail->next = block;
+        else
+            r->head = block;
+        r->tail = block;
+        r->buffered += block->len;
+        pthread_cond_broadcast(&par->cond);
+    }
+    pthread_mutex_unlock(&par->lock);
+    if (stop)
+        free(block);
+    return stop ? -1 : 0;
+}
+
+/*
+ * 解壓一段幀：啟動一個 zstd 子進程，用 poll 交替送入壓縮數據、收取解壓結果。
+ * 結果按 ZSTD_BLOCK_BYTES 分塊排隊；隊列達到額度時本線程停在 queue_block，
+ * 子進程隨之因管道寫滿而暫停，內存佔用不超過額度。
+ */
+static void *zstd_range_thread(void *arg)
+{
+    struct ZstdRange *r = (struct ZstdRange *)arg;
+    struct ZstdParallel *par = r->par;
+    const unsigned char *src = (const unsigned char *)par->d->map + r->start;
+    int error = 0;
+    int in_pipe[2], out_pipe[2];
+    pid_t pid = -1;
+    if (cloexec_pipe(in_pipe) != 0) {
+        error = errno;
+        goto done;
+    }
+    if (cloexec_pipe(out_pipe) != 0) {
+        error = errno;
+        close(in_pipe[0]);
+        close(in_pipe[1]);
+        goto done;
+    }
+    error = spawn_zstd(NULL, in_pipe[0], out_pipe[1], &pid);
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+    if (error != 0) {
+        pid = -1;
+        close(in_pipe[1]);
+        close(out_pipe[0]);
+        goto done;
+    }
+
+    int in_fd = in_pipe[1];
+    int out_fd = out_pipe[0];
+    fcntl(in_fd, F_SETFL, fcntl(in_fd, F_GETFL) | O_NONBLOCK);
+    size_t sent = 0;
+    struct ZstdBlock *block = NULL;
+    for (;;) {
+        struct pollfd pfd[2];
+        int nfds = 0;
+        pfd[nfds].fd = out_fd;
+        pfd[nfds++].events = POLLIN;
+        if (in_fd >= 0) {
+            pfd[nfds].fd = in_fd;
+            pfd[nfds++].events = POLLOUT;
+        }
+        if (poll(pfd, (nfds_t)nfds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            error = errno;
+            break;
+        }
+
+        if (in_fd >= 0 && pfd[1].revents) {
+            ssize_t w = write(in_fd, src + sent, r->len - sent);
+            if (w > 0)
+                sent += (size_t)w;
+            // 子進程提前退出時寫入得到 EPIPE，錯誤由它的退出狀態報告
+            if (sent == r->len || (w < 0 && errno != EAGAIN && errno != EINTR)) {
+                close(in_fd);
+                in_fd = -1;
+            }
+        }
+
+        if (pfd[0].revents) {
+            if (!block) {
+                block = (struct ZstdBlock *)malloc(sizeof(*block) + ZSTD_BLOCK_BYTES);
+                if (!block) {
+                    error = ENOMEM;
+                    break;
+                }
+                block->len = 0;
+            }
+            ssize_t n = read(out_fd, block->data + block->len, ZSTD_BLOCK_BYTES - block->len);
+            if (n < 0 && errno != EINTR) {
+                error = errno;
+                break;
+            }
+            if (n > 0)
+                block->len += (size_t)n;
+            if ((n == 0 || block->len == ZSTD_BLOCK_BYTES) && block->len > 0) {
+                int stop = queue_block(r, block);
+                block = NULL;
+                if (stop)
+                    break;
+            }
+            if (n == 0)
+                break;
+        }
+    }
+    free(block);
+    if (in_fd >= 0)
+        close(in_fd);
+    close(out_fd);
+
+done:
+    if (pid > 0) {
+        int status;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        if (error == 0)
+            error = child_status_error(status);
+    }
+    pthread_mutex_lock(&par->lock);
+    r->error = error;
+    r->done = 1;
+    pthread_cond_broadcast(&par->cond);
+    pthread_mutex_unlock(&par->lock);
+    return NULL;
+}
+
+// 釋放一段尚未寫出的塊
+static void drop_blocks(struct ZstdRange *r)
+{
+    while (r->head) {
+        struct ZstdBlock *next = r->head->next;
+        free(r->head);
+        r->head = next;
+    }
+    r->tail = NULL;
+    r->buffered = 0;
+}
+
+/*
+ * 並行解壓的協調線程：最多同時解壓 workers 段，按原順序把每段的塊寫入管道。
+ * 每段最多排隊 range_budget 字節，解壓結果在內存中合計不超過 workers × range_budget。
+ * 停止後不再啟動新的段，已啟動的段在循環中逐個收到 stop 並被回收。
+ */
+static void *zstd_parallel_thread(void *arg)
+{
+    struct ZstdParallel *par = (struct ZstdParallel *)arg;
+    Decompressor *d = par->d;
+    size_t started = 0;
+    int stop = 0;
+
+    for (size_t i = 0; i < par->count; i++) {
+        while (!stop && started < par->count && started < i + (size_t)d->workers) {
+            struct ZstdRange *r = &par->ranges[started];
+            if (start_thread(&r->thread, zstd_range_thread, r) != 0) {
+                if (started == i) {
+                    d->error = ENOMEM;
+                    stop = 1;
+                }
+                break;
+            }
+            started++;
+        }
+        if (i >= started)
+            break;
+
+        struct ZstdRange *r = &par->ranges[i];
+        pthread_mutex_lock(&par->lock);
+        for (;;) {
+            struct ZstdBlock *block = r->head;
+            if (stop || (!block && r->done))
+                break;
+            if (!block) {
+                pthread_cond_wait(&par->cond, &par->lock);
+                continue;
+            }
+            r->head = block->next;
+            if (!r->head)
+                r->tail = NULL;
+            r->buffered -= block->len;
+            pthread_cond_broadcast(&par->cond);
+            pthread_mutex_unlock(&par->lock);
+            if (write_all(d->pipe_out, block->data, block->len) != 0)
+                stop = 1;   // 下游已關閉
+            free(block);
+            pthread_mutex_lock(&par->lock);
+        }
+        if (stop) {
+            par->stop = 1;
+            pthread_cond_broadcast(&par->cond);
+        }
+        pthread_mutex_unlock(&par->lock);
+
+        pthread_join(r->thread, NULL);
+        drop_blocks(r);
+        if (!stop && r->error) {
+            d->error = r->error;
+            stop = 1;
+            pthread_mutex_lock(&par->lock);
+            par->stop = 1;
+            pthread_cond_broadcast(&par->cond);
+            pthread_mutex_unlock(&par->lock);
+        }
+    }
+    close(d->pipe_out);
+    return NULL;
+}
+
+// 嘗試並行解壓可映射的多幀 zstd 文件。返回 0 表示已啟動，-1 表示應退回單個 zstd 進程
+static int start_zstd_parallel(Decompressor *d, int out_fd)
+{
+    struct stat st;
+    int fd = fileno(d->src);
+    if (d->workers < 2 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= (off_t)ZSTD_MIN_RANGE_BYTES)
+        return -1;
+    struct ZstdParallel *par = (struct ZstdParallel *)calloc(1, sizeof(*par));
+    if (!par)
+        return -1;
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        free(par);
+        return -1;
+    }
+    d->map = map;
+    d->map_size = (size_t)st.st_size;
+    par->d = d;
+    par->range_budget = d->budget / (size_t)d->workers;
+    if (par->range_budget < ZSTD_BLOCK_BYTES)
+        par->range_budget = ZSTD_BLOCK_BYTES;
+    pthread_mutex_init(&par->lock, NULL);
+    pthread_cond_init(&par->cond, NULL);
+    d->parallel = par;
+    if (split_zstd_ranges(par) != 0) {
+        d->pipe_out = out_fd;
+        if (start_thread(&d->thread, zstd_parallel_thread, par) == 0) {
+            d->thread_started = 1;
+            return 0;
+        }
+    }
+    free_parallel(d);
+    return -1;
+}
+
+/*
+ * 讀取開頭最多 4 字節的魔數。可回退的輸入讀完後回到原位置，seekable 表示 src 是從開頭讀起的文件 path；
+ * 管道等不可回退的輸入直接從文件描述符讀取，讀走的字節存入 d->prefix，
+ * 由解壓線程或（未壓縮時）讀取 fp 的一方放回數據開頭。
+ * 返回讀到的字節數，-1 表示讀取失敗。
+ */
+static ssize_t peek_magic(Decompressor *d, unsigned char magic[4], int *seekable)
+{
+    *seekable = 0;
+    long pos = ftell(d->src);
+    if (pos >= 0) {
+        size_t n = fread(magic, 1, 4, d->src);
+        if (ferror(d->src) || fseek(d->src, pos, SEEK_SET) != 0)
+            return -1;
+        *seekable = d->path && pos == 0;
+        return (ssize_t)n;
+    }
+
+    // 尚未經過 FILE 緩衝，直接讀描述符，避免把後面的數據也讀進 src 的緩衝區
+    int fd = fileno(d->src);
+    while (d->prefix_len < sizeof(d->prefix)) {
+        ssize_t n = read(fd, d->prefix + d->prefix_len, sizeof(d->prefix) - d->prefix_len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+        d->prefix_len += (size_t)n;
+    }
+    memcpy(magic, d->prefix, d->prefix_len);
+    return (ssize_t)d->prefix_len;
+}
+
+int decompress_open(FILE *src, const char *path, int workers, size_t budget, Decompressor *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->fp = src;
+    d->src = src;
+    d->path = path;
+    d->workers = workers;
+    d->budget = budget;
+    d->pipe_out = -1;
+    d->pipe_in = -1;
+
+    unsigned char magic[4] = {0};
+    int seekable;
+    ssize_t n = peek_magic(d, magic, &seekable);
+    if (n < 0)
+        return -1;
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        d->format = DECOMPRESS_GZIP;
+    } else if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        d->format = DECOMPRESS_ZSTD;
+    } else {
+        return 0;   // 未壓縮：直接讀 src，不可回退時先處理 prefix 中的字節
+    }
+
+    int fds[2];
+    if (cloexec_pipe(fds) != 0)
+        return -1;
+    enlarge_pipe(fds[1]);
+
+    int ret;
+    if (d->format == DECOMPRESS_GZIP) {
+        d->pipe_out = fds[1];
+        ret = start_thread(&d->thread, gzip_thread, d) == 0 ? 0 : -1;
+        if (ret == 0)
+            d->thread_started = 1;
+        else
+            close(fds[1]);
+    } else if (seekable && start_zstd_parallel(d, fds[1]) == 0) {
+        ret = 0;
+    } else {
+        ret = start_zstd(d, fds[1], seekable);
+        close(fds[1]);
+    }
+    if (ret != 0) {
+        int saved = errno;
+        close(fds[0]);
+        errno = saved;
+        return -1;
+    }
+
+    d->fp = fdopen(fds[0], "rb");
+    if (!d->fp) {
+        close(fds[0]);
+        decompress_close(d);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+int decompress_close(Decompressor *d)
+{
+    if (d->fp == d->src)
+        return 0;
+    if (d->fp)
+        fclose(d->fp);
+    d->fp = NULL;
+    if (d->thread_started)
+        pthread_join(d->thread, NULL);
+    if (d->child > 0) {
+        int status;
+        while (waitpid((pid_t)d->child, &status, 0) < 0 && errno == EINTR) {
+        }
+        int err = child_status_error(status);
+        if (err != 0 && d->error == 0)
+            d->error = err;
+    }
+    free_parallel(d);
+    if (d->error) {
+        errno = d->error == ENOENT ? ENOENT : EIO;
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+// Windows 版本不解壓，壓縮輸入請先用外部工具解壓
+int decompress_open(FILE *src, const char *path, int workers, size_t budget, Decompressor *d)
+{
+    (void)workers;
+    (void)budget;
+    memset(d, 0, sizeof(*d));
+    d->fp = src;
+    d->src = src;
+    d->path = path;
+    return 0;
+}
+
+int decompress_close(Decompressor *d)
+{
+    (void)d;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include <stdio.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DECOMPRESS_NONE 0
+#define DECOMPRESS_GZIP 1
+#define DECOMPRESS_ZSTD 2
+
+struct ZstdParallel;
+
+/*
+ * 解壓流水線的第一級。壓縮輸入在後台解壓並寫入一條管道，fp 是管道的讀端，
+ * 下游（讀取線程或整塊讀入）照常讀取 fp，解壓與解碼同時進行：
+ *   gzip：進程內的解壓線程（zlib），支持多個成員首尾相接的文件；
+ *   zstd：外部 zstd 進程，標準輸入的內容由一個轉發線程送入。多幀的 zstd 文件按幀邊界分段，
+ *         最多 workers 個 zstd 進程同時解壓各段，結果按原順序寫入管道（pzstd、zstd -T 的輸出都是多幀）；
+ *         尚未輪到寫出的解壓結果合計不超過 budget 字節，超出時對應的 zstd 進程暫停。
+ * 未壓縮的輸入 fp 就是 src 本身。管道等不可回退的輸入在檢測格式時已讀走開頭最多 4 字節，
+ * 存在 prefix 中：format 為 DECOMPRESS_NONE 時，讀取 fp 的一方要把 prefix[0..prefix_len) 放在內容之前
+ * （見 input_load_stream 和 StreamConfig.prefix）；壓縮的輸入由解壓線程自行補回。
+ * 解壓線程屏蔽 SIGPIPE，不改變進程對 SIGPIPE 的處理。
+ */
+typedef struct {
+    FILE *fp;
+    int format;                  // DECOMPRESS_*
+    FILE *src;
+    const char *path;
+    int pipe_out;                // gzip 解壓線程寫入的管道
+    int pipe_in;                 // zstd 讀標準輸入時，轉發線程寫入的管道
+    pthread_t thread;            // gzip 解壓線程或 zstd 轉發線程
+    int thread_started;
+    int child;                   // zstd 子進程號，0 表示沒有
+    int error;                   // 解壓遇到的錯誤：EIO 為數據損壞或讀取失敗，ENOENT 為找不到 zstd
+    int workers;                 // 並行解壓 zstd 時同時運行的子進程數上限
+    size_t budget;               // 並行解壓時排隊等待寫出的解壓結果上限（字節）
+    void *map;                   // 並行解壓時整個 zstd 文件的映射
+    size_t map_size;
+    struct ZstdParallel *parallel;
+    unsigned char prefix[4];     // 不可回退的輸入在檢測格式時讀走的字節（見上）
+    size_t prefix_len;
+} Decompressor;
+
+/*
+ * 按開頭的完整魔數（gzip 為 1f 8b，zstd 為 28 b5 2f fd）檢測 src 的格式並啟動相應的解壓。
+ * path 為 src 對應的文件路徑，標準輸入傳 NULL。src 必須尚未被讀取過。
+ * workers 為並行解壓 zstd 文件時的子進程數上限，通常傳工作線程數；budget 為其排隊結果的內存上限，
+ * 通常與下游流水線的預算（塊大小 × 塊數）相同。
+ * 返回 0 表示成功，-1 表示失敗（errno 保存原因）。src 由調用者關閉，且要在 decompress_close 之後。
+ */
+int decompress_open(FILE *src, const char *path, int workers, size_t budget, Decompressor *d);
+
+/*
+ * 按 RFC 8878 走過 data 開頭的一個 zstd 幀（或可跳過幀）的頭部和各個塊頭，返回幀的總長度，不解壓。
+ * 返回 0 表示數據不完整或不是合法的幀。並行解壓用它在幀邊界上分段。
+ */
+size_t decompress_zstd_frame_size(const void *data, size_t avail);
+
+// 關閉 fp，等待解壓線程或子進程結束。返回 0 表示解壓完整無誤，-1 表示失敗：
+// errno 為 EIO 表示輸入損壞或被截斷，ENOENT 表示 PATH 中找不到 zstd 命令。
+int decompress_close(Decompressor *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECOMPRESS_H
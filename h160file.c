@@ -0,0 +1,160 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "h160file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+    return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+int h160_write_header(FILE *fp, uint64_t count, uint32_t record_size, uint32_t flags)
+{
+    uint8_t header[H160_HEADER_SIZE] = {0};
+    memcpy(header, H160_MAGIC, sizeof(H160_MAGIC));
+    put_le32(header + 8, H160_VERSION);
+    put_le32(header + 12, record_size);
+    put_le64(header + 16, count);
+    put_le32(header + 24, flags);
+    return fwrite(header, 1, sizeof(header), fp) == sizeof(header) ? 0 : -1;
+}
+
+// 校驗文件頭及文件大小，填寫 f 中除 base/size/is_mapped 以外的字段
+static int parse_header(H160File *f)
+{
+    const uint8_t *p = (const uint8_t *)f->base;
+    if (f->size < H160_HEADER_SIZE || memcmp(p, H160_MAGIC, sizeof(H160_MAGIC)) != 0 ||
+        get_le32(p + 8) != H160_VERSION)
+        return -1;
+    f->record_size = get_le32(p + 12);
+    f->count = get_le64(p + 16);
+    f->flags = get_le32(p + 24);
+    if (f->record_size == 0 ||
+        f->count > (uint64_t)(f->size - H160_HEADER_SIZE) / f->record_size ||
+        H160_HEADER_SIZE + f->count * f->record_size != f->size)
+        return -1;
+    f->records = p + H160_HEADER_SIZE;
+    return 0;
+}
+
+int h160_map_file(const char *path, void **base, size_t *size, int *is_mapped)
+{
+    *base = NULL;
+    *size = 0;
+    *is_mapped = 0;
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return -1;
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    long len = ftell(fp);
+    rewind(fp);
+    void *buf = len > 0 ? malloc((size_t)len) : NULL;
+    if (!buf || fread(buf, 1, (size_t)len, fp) != (size_t)len) {
+        free(buf);
+        fclose(fp);
+        errno = len > 0 ? EIO : EINVAL;
+        return -1;
+    }
+    fclose(fp);
+    *base = buf;
+    *size = (size_t)len;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    int saved = errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        errno = saved;
+        return -1;
+    }
+    // 查詢是隨機訪問，不需要預讀
+#ifdef MADV_RANDOM
+    madvise(map, len, MADV_RANDOM);
+#endif
+    *base = map;
+    *size = len;
+    *is_mapped = 1;
+#endif
+    return 0;
+}
+
+void h160_unmap_file(void *base, size_t size, int is_mapped)
+{
+    if (!base)
+        return;
+#ifndef _WIN32
+    if (is_mapped)
+        munmap(base, size);
+    else
+#endif
+        free(base);
+    (void)size;
+    (void)is_mapped;
+}
+
+int h160_open(const char *path, H160File *f)
+{
+    memset(f, 0, sizeof(*f));
+    if (h160_map_file(path, &f->base, &f->size, &f->is_mapped) != 0)
+        return -1;
+    if (parse_header(f) != 0) {
+        h160_close(f);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+void h160_close(H160File *f)
+{
+    h160_unmap_file(f->base, f->size, f->is_mapped);
+    memset(f, 0, sizeof(*f));
+}
@@ -0,0 +1,64 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef H160FILE_H
+#define H160FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * .h160 文件佈局（所有整數均為小端序）：
+ *
+ *   偏移  長度  內容
+ *   0     8     魔數 "HASH160\0"
+ *   8     4     版本號，當前為 1
+ *   12    4     記錄寬度（字節），hash160 為 20
+ *   16    8     記錄數
+ *   24    4     標誌：bit 0 已排序，bit 1 已去重
+ *   28    4     保留，寫 0
+ *   32    ...   記錄數 × 記錄寬度 的緊湊記錄，無填充
+ *
+ * 文件大小恰好為 32 + 記錄數 × 記錄寬度。已排序的文件可以直接 mmap 後二分查找，無需解析。
+ */
+#define H160_MAGIC        "HASH160"
+#define H160_VERSION      1
+#define H160_HEADER_SIZE  32
+#define H160_FLAG_SORTED  0x1u
+#define H160_FLAG_UNIQUE  0x2u
+
+// 已打開（映射）的 .h160 文件
+typedef struct {
+    void *base;                // 映射或讀入的整個文件
+    size_t size;               // 文件字節數
+    int is_mapped;             // 1 表示 base 來自 mmap，0 表示來自 malloc
+    const uint8_t *records;    // 第一條記錄
+    uint64_t count;            // 記錄數
+    uint32_t record_size;      // 記錄寬度
+    uint32_t flags;            // H160_FLAG_*
+} H160File;
+
+// 寫出 32 字節文件頭，記錄由調用者隨後寫出。返回 0 表示成功，-1 表示寫入失敗。
+int h160_write_header(FILE *fp, uint64_t count, uint32_t record_size, uint32_t flags);
+
+// 映射並校驗 .h160 文件。返回 0 表示成功；-1 表示失敗，errno 保存原因（格式不符時為 EINVAL）。
+int h160_open(const char *path, H160File *f);
+
+// 解除映射並清零
+void h160_close(H160File *f);
+
+// 只讀映射整個普通文件（其他平台整塊讀入）。返回 0 表示成功，-1 表示失敗（errno 保存原因）。
+int h160_map_file(const char *path, void **base, size_t *size, int *is_mapped);
+// 釋放 h160_map_file 得到的內容
+void h160_unmap_file(void *base, size_t size, int is_mapped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // H160FILE_H
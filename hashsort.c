@@ -0,0 +1,271 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashsort.h"
+
+/*
+ * MSD 基數排序（American flag sort）：每層按一個字節把區間分成 256 個桶，桶內就地交換歸位，
+ * 再對每個桶遞歸處理下一個字節。hash160 分佈均勻，兩層之後桶內通常只剩幾個元素，
+ * 小區間改用插入排序。
+ */
+#define RADIX_INSERTION_MAX 24
+
+static inline void swap_key(uint8_t *a, uint8_t *b)
+{
+    uint8_t t[HASH160_SIZE];
+    memcpy(t, a, HASH160_SIZE);
+    memcpy(a, b, HASH160_SIZE);
+    memcpy(b, t, HASH160_SIZE);
+}
+
+// 前 depth 個字節已相同，只比較其後的部分
+static void insertion_sort(uint8_t *keys, size_t n, size_t depth)
+{
+    uint8_t key[HASH160_SIZE];
+    for (size_t i = 1; i < n; i++) {
+        uint8_t *p = keys + i * HASH160_SIZE;
+        if (memcmp(p - HASH160_SIZE + depth, p + depth, HASH160_SIZE - depth) <= 0)
+            continue;
+        memcpy(key, p, HASH160_SIZE);
+        size_t j = i;
+        do {
+            memcpy(keys + j * HASH160_SIZE, keys + (j - 1) * HASH160_SIZE, HASH160_SIZE);
+            j--;
+        } while (j > 0 && memcmp(keys + (j - 1) * HASH160_SIZE + depth, key + depth, HASH160_SIZE - depth) > 0);
+        memcpy(keys + j * HASH160_SIZE, key, HASH160_SIZE);
+    }
+}
+
+static void radix_sort(uint8_t *keys, size_t n, size_t depth)
+{
+    if (n <= RADIX_INSERTION_MAX) {
+        insertion_sort(keys, n, depth);
+        return;
+    }
+
+    size_t count[256] = {0};
+    for (size_t i = 0; i < n; i++)
+        count[keys[i * HASH160_SIZE + depth]]++;
+
+    size_t next[256], end[256];
+    size_t pos = 0;
+    for (int b = 0; b < 256; b++) {
+        next[b] = pos;
+        pos += count[b];
+        end[b] = pos;
+    }
+
+    // 每次交換都把一個元素放進它所屬的桶
+    for (int b = 0; b < 256; b++) {
+        while (next[b] < end[b]) {
+            uint8_t *p = keys + next[b] * HASH160_SIZE;
+            unsigned d = p[depth];
+            if (d == (unsigned)b) {
+                next[b]++;
+            } else {
+                swap_key(p, keys + next[d] * HASH160_SIZE);
+                next[d]++;
+            }
+        }
+    }
+
+    if (depth + 1 == HASH160_SIZE)
+        return;
+    pos = 0;
+    for (int b = 0; b < 256; b++) {
+        if (count[b] > 1)
+            radix_sort(keys + pos * HASH160_SIZE, count[b], depth + 1);
+        pos += count[b];
+    }
+}
+
+void hash160_sort(uint8_t *keys, size_t n)
+{
+    if (n > 1)
+        radix_sort(keys, n, 0);
+}
+
+size_t hash160_dedup(uint8_t *keys, size_t n)
+{
+    if (n == 0)
+        return 0;
+    size_t out = 1;
+    for (size_t i = 1; i < n; i++) {
+        const uint8_t *p = keys + i * HASH160_SIZE;
+        if (memcmp(p, keys + (out - 1) * HASH160_SIZE, HASH160_SIZE) != 0) {
+            if (out != i)
+                memcpy(keys + out * HASH160_SIZE, p, HASH160_SIZE);
+            out++;
+        }
+    }
+    return out;
+}
+
+size_t hash160_lower_bound(const uint8_t *keys, size_t n, const uint8_t *key)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (memcmp(keys + mid * HASH160_SIZE, key, HASH160_SIZE) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static inline uint64_t key_prefix64(const uint8_t *key)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v = (v << 8) | key[i];
+    return v;
+}
+
+// 剩餘區間不超過這個長度時改用二分查找
+#define INTERP_MIN_RANGE 16
+
+size_t hash160_interp_lower_bound(const uint8_t *keys, size_t n, const uint8_t *key)
+{
+    // 不變式：keys[0..lo) < key，keys[hi..n) >= key
+    size_t lo = 0, hi = n;
+    uint64_t kv = key_prefix64(key);
+    while (hi - lo > INTERP_MIN_RANGE) {
+        uint64_t lv = key_prefix64(keys + lo * HASH160_SIZE);
+        uint64_t hv = key_prefix64(keys + (hi - 1) * HASH160_SIZE);
+        size_t pos;
+        if (kv <= lv || hv <= lv)
+            pos = lo;
+        else if (kv >= hv)
+            pos = hi - 1;
+        else
+            pos = lo + (size_t)((unsigned __int128)(kv - lv) * (hi - 1 - lo) / (hv - lv));
+
+        size_t before = hi - lo;
+        if (memcmp(keys + pos * HASH160_SIZE, key, HASH160_SIZE) < 0)
+            lo = pos + 1;
+        else
+            hi = pos;
+
+        // 插值未能把區間縮小一半時補一次二分，避免分佈不均時退化為線性
+        if (hi - lo > before / 2 && hi - lo > INTERP_MIN_RANGE) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (memcmp(keys + mid * HASH160_SIZE, key, HASH160_SIZE) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+    return lo + hash160_lower_bound(keys + lo * HASH160_SIZE, hi - lo, key);
+}
+
+// 每路每個區間抽取的樣本數
+#define SPLITTER_OVERSAMPLE 8
+
+int hash160_pick_splitters(const uint8_t *const runs[], const size_t lens[], size_t k,
+                           size_t parts, uint8_t *splitters)
+{
+    if (parts < 2)
+        return 0;
+
+    size_t per_run = parts * SPLITTER_OVERSAMPLE;
+    uint8_t *samples = (uint8_t *)malloc(k * per_run * HASH160_SIZE);
+    if (!samples)
+        return -1;
+
+    // 每路按等間距抽樣，樣本數與該路長度成比例，保證各路按數據量加權
+    size_t total = 0;
+    for (size_t r = 0; r < k; r++)
+        total += lens[r];
+    size_t m = 0;
+    for (size_t r = 0; r < k; r++) {
+        if (lens[r] == 0)
+            continue;
+        size_t s = total ? (size_t)((unsigned long long)per_run * k * lens[r] / total) : 0;
+        if (s == 0)
+            s = 1;
+        if (s > per_run)
+            s = per_run;
+        for (size_t j = 0; j < s; j++) {
+            size_t idx = (size_t)((unsigned long long)lens[r] * (2 * j + 1) / (2 * s));
+            memcpy(samples + m * HASH160_SIZE, runs[r] + idx * HASH160_SIZE, HASH160_SIZE);
+            m++;
+        }
+    }
+
+    if (m == 0) {
+        memset(splitters, 0, (parts - 1) * HASH160_SIZE);
+    } else {
+        hash160_sort(samples, m);
+        for (size_t p = 1; p < parts; p++)
+            memcpy(splitters + (p - 1) * HASH160_SIZE, samples + (p * m / parts) * HASH160_SIZE, HASH160_SIZE);
+    }
+    free(samples);
+    return 0;
+}
+
+/*
+ * 二叉小頂堆，堆中存放各路當前位置的下標。k 通常等於線程數，
+ * 每取出一個鍵只需一次 log k 的下沉。
+ */
+typedef struct {
+    const uint8_t *cur;
+    const uint8_t *end;
+} MergeRun;
+
+static void heap_sift_down(MergeRun *heap, size_t n, size_t i)
+{
+    MergeRun x = heap[i];
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= n)
+            break;
+        if (c + 1 < n && memcmp(heap[c + 1].cur, heap[c].cur, HASH160_SIZE) < 0)
+            c++;
+        if (memcmp(heap[c].cur, x.cur, HASH160_SIZE) >= 0)
+            break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = x;
+}
+
+size_t hash160_merge_unique(const uint8_t *const runs[], const size_t lens[], size_t k, uint8_t *out)
+{
+    MergeRun stack_heap[64];
+    MergeRun *heap = k <= 64 ? stack_heap : (MergeRun *)malloc(k * sizeof(MergeRun));
+    size_t n = 0, written = 0;
+
+    if (!heap)
+        return (size_t)-1;
+
+    for (size_t r = 0; r < k; r++) {
+        if (lens[r] == 0)
+            continue;
+        heap[n].cur = runs[r];
+        heap[n].end = runs[r] + lens[r] * HASH160_SIZE;
+        n++;
+    }
+    for (size_t i = n / 2; i-- > 0;)
+        heap_sift_down(heap, n, i);
+
+    while (n > 0) {
+        const uint8_t *p = heap[0].cur;
+        if (written == 0 || memcmp(p, out + (written - 1) * HASH160_SIZE, HASH160_SIZE) != 0) {
+            memcpy(out + written * HASH160_SIZE, p, HASH160_SIZE);
+            written++;
+        }
+        heap[0].cur += HASH160_SIZE;
+        if (heap[0].cur == heap[0].end)
+            heap[0] = heap[--n];
+        if (n > 0)
+            heap_sift_down(heap, n, 0);
+    }
+
+    if (heap != stack_heap)
+        free(heap);
+    return written;
+}
@@ -0,0 +1,44 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef HASHSORT_H
+#define HASHSORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HASH160_SIZE 20
+
+// 對 n 個連續存放的 20 字節 hash160 就地排序（按字節比較，與小寫十六進制字符串的字典序一致）
+void hash160_sort(uint8_t *keys, size_t n);
+
+// 已排序數組中相鄰的重複項只保留一個，返回去重後的數量
+size_t hash160_dedup(uint8_t *keys, size_t n);
+
+// 返回已排序數組中第一個不小於 key 的位置
+size_t hash160_lower_bound(const uint8_t *keys, size_t n, const uint8_t *key);
+
+// 同 hash160_lower_bound，但按鍵的前 8 字節做插值查找，適合均勻分佈的大數組；
+// 分佈不均時每次插值後補一次二分，最壞情況仍為 O(log n) 次比較
+size_t hash160_interp_lower_bound(const uint8_t *keys, size_t n, const uint8_t *key);
+
+/*
+ * 從 k 路已排序數據中抽樣，選出 parts - 1 個遞增的分割點寫入 splitters，
+ * 使按 [splitters[p-1], splitters[p]) 劃分的 parts 個區間大小大致相等。
+ * 相同的鍵總在同一區間內。內存分配失敗返回 -1，成功返回 0。
+ */
+int hash160_pick_splitters(const uint8_t *const runs[], const size_t lens[], size_t k,
+                           size_t parts, uint8_t *splitters);
+
+// k 路歸併已排序數據到 out，歸併過程中去除重複項，返回寫入的鍵數；內存分配失敗返回 (size_t)-1
+size_t hash160_merge_unique(const uint8_t *const runs[], const size_t lens[], size_t k, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HASHSORT_H
@@ -0,0 +1,98 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "hex.h"
+
+// 構建時使用 -march=native，按編譯器開啟的指令集選擇 SIMD 路徑；尾部和其他平台使用查表
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// 字符 -> 4 位值，-1 表示非十六進制字符
+static const int8_t HEX_VALUE[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+void hex_encode(const uint8_t *bytes, size_t len, char *out)
+{
+    size_t i = 0;
+#if defined(__SSSE3__)
+    // 每次 16 字節：高低半字節分別查表（pshufb），再交錯成 32 個字符
+    const __m128i lut = _mm_loadu_si128((const __m128i *)HEX_DIGITS);
+    const __m128i low4 = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(bytes + i));
+        __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(x, 4), low4));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(x, low4));
+        _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    for (; i < len; i++) {
+        out[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0f];
+    }
+    out[2 * len] = '\0';
+}
+
+#if defined(__SSSE3__)
+/*
+ * 16 個字符 -> 8 字節。數字與字母（不分大小寫）分別按無符號範圍判斷，
+ * 任一字符不合法時返回 0。
+ */
+static inline int hex_decode16(const char *hex, uint8_t *out)
+{
+    __m128i c = _mm_loadu_si128((const __m128i *)hex);
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(a, _mm_set1_epi8(5)), a);
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff)
+        return 0;
+    __m128i v = _mm_or_si128(_mm_and_si128(is_digit, d),
+                             _mm_and_si128(is_alpha, _mm_add_epi8(a, _mm_set1_epi8(10))));
+    // 相鄰兩個 4 位值合成一個字節：v[2k] * 16 + v[2k+1]
+    __m128i w = _mm_maddubs_epi16(v, _mm_set1_epi16(0x0110));
+    _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(w, w));
+    return 1;
+}
+#endif
+
+int hex_decode(const char *hex, size_t hex_len, uint8_t *out, size_t max_out)
+{
+    if (hex_len % 2 != 0 || hex_len / 2 > max_out)
+        return -1;
+    size_t n = hex_len / 2;
+    size_t i = 0;
+#if defined(__SSSE3__)
+    for (; i + 8 <= n; i += 8) {
+        if (!hex_decode16(hex + 2 * i, out + i))
+            return -1;
+    }
+#endif
+    for (; i < n; i++) {
+        int hi = HEX_VALUE[(unsigned char)hex[2 * i]];
+        int lo = HEX_VALUE[(unsigned char)hex[2 * i + 1]];
+        if ((hi | lo) < 0)
+            return -1;
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return (int)n;
+}
@@ -0,0 +1,25 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef HEX_H
+#define HEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 把 len 字節編碼為 2 * len 個小寫十六進制字符並以 '\0' 結尾（out 至少 2 * len + 1 字節）
+void hex_encode(const uint8_t *bytes, size_t len, char *out);
+
+// 解碼 hex_len 個十六進制字符（大小寫均可）到 out，返回字節數。
+// 長度為奇數、解碼後超過 max_out 字節或含有非十六進制字符時返回 -1。
+int hex_decode(const char *hex, size_t hex_len, uint8_t *out, size_t max_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEX_H
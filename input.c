@@ -0,0 +1,209 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "input.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+ * 在 data 中就地查找行邊界，建立 LineView 數組。
+ * 與 fgets 逐行讀取的語義一致：以 '\n' 分行，最後一行沒有 '\n' 時也算一行，
+ * 數據以 '\n' 結尾時不會多出空行。
+ */
+int input_index_range(const char *data, size_t size, LineView **lines_io, size_t *count_out, size_t *capacity_io) {
+    LineView *lines = *lines_io;
+    size_t capacity = *capacity_io;
+    if (!lines || capacity == 0) {
+        capacity = size / 32 + 16;
+        lines = (LineView *)malloc(capacity * sizeof(LineView));
+        if (!lines)
+            return -1;
+        *lines_io = lines;
+        *capacity_io = capacity;
+    }
+
+    size_t count = 0;
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end) {
+        const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+        size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+        if (count >= capacity) {
+            capacity *= 2;
+            LineView *temp = (LineView *)realloc(lines, capacity * sizeof(LineView));
+            if (!temp)
+                return -1;
+            lines = temp;
+            *lines_io = lines;
+            *capacity_io = capacity;
+        }
+        lines[count].ptr = p;
+        lines[count].len = len;
+        count++;
+        if (!nl)
+            break;
+        p = nl + 1;
+    }
+
+    *count_out = count;
+    return 0;
+}
+
+static int index_lines(InputBuffer *in) {
+    size_t capacity = 0;
+    return input_index_range(in->data, in->size, &in->lines, &in->count, &capacity);
+}
+
+/*
+ * 内部函數：把 prefix 和整個流讀入一塊連續的堆內存
+ */
+static int read_all(FILE *fp, const void *prefix, size_t prefix_len, InputBuffer *in) {
+    size_t capacity = 1 << 20;
+    size_t size = prefix_len;
+    char *data = (char *)malloc(capacity);
+    if (!data)
+        return -1;
+    if (prefix_len > 0)
+        memcpy(data, prefix, prefix_len);
+
+    for (;;) {
+        if (size == capacity) {
+            capacity *= 2;
+            char *temp = (char *)realloc(data, capacity);
+            if (!temp) {
+                free(data);
+                return -1;
+            }
+            data = temp;
+        }
+        size_t n = fread(data + size, 1, capacity - size, fp);
+        size += n;
+        if (n == 0) {
+            if (ferror(fp)) {
+                free(data);
+                return -1;
+            }
+            break;
+        }
+    }
+
+    in->data = data;
+    in->size = size;
+    in->is_mapped = 0;
+    return 0;
+}
+
+int input_load_stream(FILE *fp, const void *prefix, size_t prefix_len, InputBuffer *in) {
+    memset(in, 0, sizeof(*in));
+    if (read_all(fp, prefix, prefix_len, in) != 0)
+        return -1;
+    if (index_lines(in) != 0) {
+        input_free(in);
+        return -1;
+    }
+    return 0;
+}
+
+int input_load_string(const char *s, InputBuffer *in) {
+    memset(in, 0, sizeof(*in));
+    in->size = strlen(s);
+    in->data = (char *)malloc(in->size + 1);
+    if (!in->data)
+        return -1;
+    memcpy(in->data, s, in->size + 1);
+    in->lines = (LineView *)malloc(sizeof(LineView));
+    if (!in->lines) {
+        input_free(in);
+        return -1;
+    }
+    in->lines[0].ptr = in->data;
+    in->lines[0].len = in->size;
+    in->count = 1;
+    return 0;
+}
+
+int input_load_file(const char *path, InputBuffer *in) {
+    memset(in, 0, sizeof(*in));
+#ifdef _WIN32
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    int ret = input_load_stream(fp, NULL, 0, in);
+    fclose(fp);
+    return ret;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    // 管道、字符設備等無法映射，退回整塊讀入
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        FILE *fp = fdopen(fd, "r");
+        if (!fp) {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return -1;
+        }
+        int ret = input_load_stream(fp, NULL, 0, in);
+        fclose(fp);
+        return ret;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int saved = errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        errno = saved;
+        return -1;
+    }
+
+    // 行索引階段順序掃描；之後各線程各自順序讀取自己的範圍
+#ifdef MADV_SEQUENTIAL
+    madvise(map, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+    madvise(map, size, MADV_HUGEPAGE);
+#endif
+
+    in->data = (char *)map;
+    in->size = size;
+    in->is_mapped = 1;
+    if (index_lines(in) != 0) {
+        input_free(in);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+void input_free(InputBuffer *in) {
+    if (in->data) {
+#ifndef _WIN32
+        if (in->is_mapped)
+            munmap(in->data, in->size);
+        else
+#endif
+            free(in->data);
+    }
+    free(in->lines);
+    memset(in, 0, sizeof(*in));
+}
@@ -0,0 +1,51 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 一行輸入的視圖：指向輸入緩衝區（或文件映射）內部，不含結尾的 '\n'，也不以 '\0' 結尾
+typedef struct {
+    const char *ptr;
+    size_t len;
+} LineView;
+
+// 整個輸入的內容及其行索引
+typedef struct {
+    char *data;        // 文件映射或一次性讀入的內容
+    size_t size;       // data 的字節數
+    int is_mapped;     // 1 表示 data 來自 mmap，0 表示來自 malloc
+    LineView *lines;   // 行視圖數組
+    size_t count;      // 行數
+} InputBuffer;
+
+// 打開文件並建立行索引。普通文件使用 mmap 零拷貝映射，其他文件（管道、設備等）整塊讀入。
+// 返回 0 表示成功，-1 表示失敗（errno 保存原因，文件不存在時為 ENOENT）。
+int input_load_file(const char *path, InputBuffer *in);
+
+// 從已打開的流（例如 stdin）整塊讀入並建立行索引。prefix 為已從 fp 讀走、應放在內容開頭的
+// prefix_len 個字節（沒有時傳 NULL/0）。返回 0 表示成功，-1 表示失敗。
+int input_load_stream(FILE *fp, const void *prefix, size_t prefix_len, InputBuffer *in);
+
+// 把單個字符串（例如命令行上的地址）作為一行輸入。返回 0 表示成功，-1 表示失敗。
+int input_load_string(const char *s, InputBuffer *in);
+
+// 在 data[0..size) 中就地建立行索引。*lines_io/*capacity_io 為可重複使用的 LineView 數組及其容量
+// （首次調用時可為 NULL/0，函數內部按需分配或擴容）。返回 0 表示成功，-1 表示內存不足。
+int input_index_range(const char *data, size_t size, LineView **lines_io, size_t *count_out, size_t *capacity_io);
+
+// 釋放映射、緩衝區及行索引
+void input_free(InputBuffer *in);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INPUT_H
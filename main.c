@@ -1,7 +1,7 @@
 /*  https://github.com/8891689 
  *  Author: 8891689
  */
-// gcc -O3 -lpthread -Wall -Wextra -march=native -static base58.c bech32.c cashaddr.c main.c sha256.c -o decode
+// gcc -O3 -lpthread -Wall -Wextra -march=native -static affinity.c base58.c bech32.c bloom.c cashaddr.c decompress.c h160file.c hashsort.c hex.c input.c main.c polymod.c runfile.c sha256.c stream.c -lz -lm -o decode
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,356 +21,2173 @@
 #include "base58.h"
 #include "bech32.h"
 #include "cashaddr.h"
+#include "hex.h"
+#include "hashsort.h"
+#include "h160file.h"
+#include "bloom.h"
+#include "polymod.h"
+#include "input.h"
+#include "stream.h"
+#include "affinity.h"
+#include "decompress.h"
+#include "runfile.h"
 
 /* -------------------------------------------------------------------------
  * 1. 輔助函數：將字節數組轉換為十六進制字符串 
  * -------------------------------------------------------------------------*/
 static void bytes_to_hex(const unsigned char *bytes, size_t len, char *hex_str) {
+    hex_encode(bytes, len, hex_str);
+}
+
+/* -------------------------------------------------------------------------
+ * 2. 輔助函數：解析十進制餘額 
+ * -------------------------------------------------------------------------*/
+// 只接受十進制整數（聰），溢出時取最大值。返回 false 表示不是整數。
+static bool parse_balance(const char *s, size_t len, uint64_t *out) {
+    if (len == 0) return false;
+    uint64_t v = 0;
     for (size_t i = 0; i < len; i++) {
-        sprintf(&hex_str[i * 2], "%02x", bytes[i]);
+        unsigned d = (unsigned)(s[i] - '0');
+        if (d > 9) return false;
+        v = v > (UINT64_MAX - d) / 10 ? UINT64_MAX : v * 10 + d;
+    }
+    *out = v;
+    return true;
+}
+
+/* -------------------------------------------------------------------------
+ * 3. 取出一行中的某一列，不複製
+ * -------------------------------------------------------------------------*/
+// 地址列的最大長度，Base58 解碼的臨時緩衝區按此分配
+#define ADDRESS_MAX 511
+
+/*
+ * 取製表符分隔的第 column 列（從 0 起），去除首尾空白後返回其長度，*out 指向行緩衝區內部。
+ * 該列不存在時返回 0。
+ */
+static size_t line_column(const LineView *line, int column, const char **out)
+{
+    const char *p = line->ptr;
+    const char *end = line->ptr + line->len;
+    for (int c = 0; c < column; c++) {
+        const char *tab = (const char *)memchr(p, '\t', (size_t)(end - p));
+        if (!tab) return 0;
+        p = tab + 1;
+    }
+    const char *tab = (const char *)memchr(p, '\t', (size_t)(end - p));
+    if (tab) end = tab;
+    while (p < end && isspace((unsigned char)*p)) p++;
+    while (end > p && isspace((unsigned char)end[-1])) end--;
+    *out = p;
+    return (size_t)(end - p);
+}
+
+/* -------------------------------------------------------------------------
+ * 4. 地址格式分類：一次掃描得出可能接受該行的解碼器，避免逐個解碼器試錯
+ * -------------------------------------------------------------------------*/
+#define CC_BASE58 0x01   // Base58 字母表
+#define CC_BECH32 0x02   // Bech32 / CashAddr 字符集（不區分大小寫）
+#define CC_HEX    0x04   // 十六進制數字
+#define CC_LOWER  0x08
+#define CC_UPPER  0x10
+
+static const uint8_t char_class[256] = {
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x06,0x05,0x07,0x07,0x07,0x07,0x07,0x07,0x07,0x07,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x17,0x15,0x17,0x17,0x17,0x17,0x13,0x13,0x10,0x13,0x13,0x13,0x13,0x13,0x10,
+    0x13,0x13,0x13,0x13,0x13,0x13,0x13,0x13,0x13,0x13,0x13,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x0f,0x0d,0x0f,0x0f,0x0f,0x0f,0x0b,0x0b,0x09,0x0b,0x0b,0x0a,0x0b,0x0b,0x09,
+    0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+};
+
+#define FMT_BASE58   0x01
+#define FMT_BECH32   0x02
+#define FMT_CASHADDR 0x04
+#define FMT_HEX      0x08
+
+static const char *segwit_hrps[] = {"bc", "tb", "ltc", "tltc", "btg", NULL};
+
+// 解碼器返回的 HRP 是否在支持列表中
+static int is_segwit_hrp(const char *hrp) {
+    for (int i = 0; segwit_hrps[i] != NULL; ++i) {
+        if (strcmp(hrp, segwit_hrps[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+/*
+ * 返回可能解碼成功的格式集合（FMT_* 位）。
+ * 各格式的判斷只用到前綴、分隔符位置、長度和字符集，不做任何校驗和計算。
+ */
+static int classify_address(const char *addr, size_t len) {
+    uint8_t all = 0xff;
+    uint8_t any = 0;
+    long last_sep = -1;           // 最後一個 '1'：Bech32 分隔符
+    long first_colon = -1;        // 第一個 ':'：CashAddr 前綴分隔符
+    long last_non_bech32 = -1;
+    long last_non_hex = -1;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)addr[i];
+        uint8_t cls = char_class[c];
+        all &= cls | CC_LOWER | CC_UPPER;
+        any |= cls;
+        if (c == '1') last_sep = (long)i;
+        if (c == ':' && first_colon < 0) first_colon = (long)i;
+        if (!(cls & CC_BECH32)) last_non_bech32 = (long)i;
+        if (!(cls & CC_HEX)) last_non_hex = (long)i;
+    }
+
+    int fmts = 0;
+
+    // Base58Check：payload 至少 20 字節 + 4 字節校驗和，每個字符最多對應 1 字節
+    if ((all & CC_BASE58) && len >= 24) {
+        fmts |= FMT_BASE58;
+    }
+
+    // Bech32：8～90 個字符、不混合大小寫、分隔符後至少 6 個校驗字符；HRP 在解碼後檢查
+    if (len >= 8 && len <= 90 && last_sep >= 1 && (size_t)last_sep + 7 <= len &&
+        last_non_bech32 <= last_sep && !((any & CC_LOWER) && (any & CC_UPPER))) {
+        fmts |= FMT_BECH32;
+    }
+
+    // CashAddr：可選的 "前綴:"，之後至少 34 個數據字符（21 字節 payload）+ 8 個校驗字符；
+    // 冒號本身不在字符集內，因此冒號之後全部合法等價於 last_non_bech32 == first_colon
+    if (first_colon < 0) {
+        if (last_non_bech32 < 0 && len >= 42) {
+            fmts |= FMT_CASHADDR;
+        }
+    } else if (first_colon < 32 && last_non_bech32 == first_colon &&
+               len - (size_t)first_colon - 1 >= 42) {
+        fmts |= FMT_CASHADDR;
+    }
+
+    // 十六進制：可選的 0x 前綴，偶數個數字，最多 64 字節
+    size_t hex_start = (len >= 2 && addr[0] == '0' && (addr[1] == 'x' || addr[1] == 'X')) ? 2 : 0;
+    size_t hex_len = len - hex_start;
+    if (last_non_hex < (long)hex_start && hex_len > 0 && hex_len % 2 == 0 && hex_len / 2 <= 64) {
+        fmts |= FMT_HEX;
+    }
+
+    return fmts;
+}
+
+/* -------------------------------------------------------------------------
+ * 5. 线程相關結構和變量
+ * -------------------------------------------------------------------------*/
+
+#define LINE_HEADER              -3   // --skip-header 跳過的表頭行，不計入任何統計
+#define LINE_FILTERED            -2   // 餘額低於 --min-balance，不解碼
+#define DECODE_FAILED            -1
+#define SUCCESS_NON_STANDARD_HASH 0
+#define SUCCESS_STANDARD_HASH     1
+
+// 輸入的列格式與按餘額的篩選條件
+typedef struct {
+    int address_column;          // 地址所在列（從 0 起）
+    int balance_column;          // 餘額所在列（從 0 起）
+    bool skip_header;
+    bool min_balance_set;
+    uint64_t min_balance;        // 餘額列缺失或不是整數時按 0 計
+    size_t top_n;                // 非 0 時只保留餘額最高的 top_n 個標準哈希
+} InputFormat;
+
+static const InputFormat default_input_format = {0, 1, false, false, 0, 0};
+
+/*
+ * --top 的候選項。按餘額從高到低排序，餘額相同時行號小的優先，
+ * 因此選出的集合只取決於輸入，與線程數和分塊方式無關。
+ */
+typedef struct {
+    uint64_t balance;
+    uint64_t line;
+    unsigned char hash[HASH160_SIZE];
+} TopEntry;
+
+// a 是否排在 b 之前
+static bool top_entry_better(const TopEntry *a, const TopEntry *b)
+{
+    return a->balance != b->balance ? a->balance > b->balance : a->line < b->line;
+}
+
+static void top_heap_sift_down(TopEntry *heap, size_t n, size_t i)
+{
+    for (;;) {
+        size_t w = i, l = 2 * i + 1, r = l + 1;
+        if (l < n && top_entry_better(&heap[w], &heap[l])) w = l;
+        if (r < n && top_entry_better(&heap[w], &heap[r])) w = r;
+        if (w == i) return;
+        TopEntry t = heap[i]; heap[i] = heap[w]; heap[w] = t;
+        i = w;
+    }
+}
+
+/*
+ * 把一項放入最多保留 limit 項的堆（堆頂是當前最差的一項）。數組按需倍增，最多 limit 項。
+ * 返回 0 表示成功，-1 表示內存不足。
+ */
+static int top_heap_push(TopEntry **heap, size_t *count, size_t *capacity, size_t limit, const TopEntry *e)
+{
+    if (*count == limit) {
+        if (top_entry_better(e, &(*heap)[0])) {
+            (*heap)[0] = *e;
+            top_heap_sift_down(*heap, *count, 0);
+        }
+        return 0;
+    }
+    if (*count == *capacity) {
+        size_t cap = *capacity ? *capacity * 2 : 1024;
+        if (cap > limit) cap = limit;
+        TopEntry *temp = (TopEntry *)realloc(*heap, cap * sizeof(TopEntry));
+        if (!temp) return -1;
+        *heap = temp;
+        *capacity = cap;
+    }
+    size_t i = (*count)++;
+    while (i > 0 && top_entry_better(&(*heap)[(i - 1) / 2], e)) {
+        (*heap)[i] = (*heap)[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    (*heap)[i] = *e;
+    return 0;
+}
+
+static int top_entry_compare(const void *a, const void *b)
+{
+    const TopEntry *x = (const TopEntry *)a, *y = (const TopEntry *)b;
+    return top_entry_better(x, y) ? -1 : top_entry_better(y, x) ? 1 : 0;
+}
+
+
+// 非標準哈希輸出的最大字節數
+#define NON_STANDARD_MAX 32
+
+/*
+ * 普通模式的結果按列存放：每行一個字節的狀態，每行一個 20 字節的哈希槽，
+ * 非標準哈希只在旁表中保存，十六進制在寫出時才生成。
+ * 旁表項按行號順序追加，各線程的旁表依次拼接即與輸入順序一致。
+ */
+typedef struct {
+    unsigned char len;           // 輸出的字節數（最多 NON_STANDARD_MAX）
+    unsigned char bytes[NON_STANDARD_MAX];
+} NonStandardEntry;
+
+// 可重複使用的線程屏障。線程創建失敗時可減少參與者數量，已啟動的線程不會永久等待
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+    int waiting;
+    unsigned long phase;
+} WorkerBarrier;
+
+typedef struct ThreadData ThreadData;
+
+// 默認每個調度塊的行數
+#define WORK_CHUNK_LINES 1024
+
+// 一個調度塊由哪個線程處理，以及塊內非標準哈希在該線程旁表中的起始位置
+typedef struct {
+    int worker;
+    size_t nonstd_start;
+} WorkChunk;
+
+// 解碼、排序與歸併階段由所有工作線程共享的狀態
+typedef struct {
+    WorkerBarrier barrier;
+    ThreadData *workers;
+    int thread_count;
+    const LineView *lines;
+    size_t line_count;
+    const InputFormat *fmt;
+    signed char *status;         // 每行的狀態
+    size_t chunk_lines;          // 每個調度塊的行數（64 的倍數，相鄰塊寫狀態數組時不共享緩存行）
+    size_t chunk_count;
+    size_t next_chunk;           // 下一個待領取的塊號，各線程原子遞增領取
+    WorkChunk *chunks;
+    unsigned char *splitters;    // thread_count - 1 個分割點，劃分各線程負責的歸併區間
+    bool failed;                 // 任一線程內存分配失敗，其後的階段全部跳過
+} SortShared;
+
+// ThreadData 結構用於傳遞給每個線程的數據 
+struct ThreadData {
+    int id;
+    SortShared *shared;
+    unsigned char *run;          // 本線程解碼出的標準哈希，排序後作為歸併的一路
+    size_t run_count;
+    size_t run_capacity;
+    size_t failed_count;         // 本線程的非標準/失敗行數
+    NonStandardEntry *nonstd;    // 本線程的非標準哈希旁表
+    size_t nonstd_count;
+    size_t nonstd_capacity;
+    unsigned char *merged;       // 本線程負責區間的歸併去重結果
+    size_t merged_count;
+    TopEntry *top;               // --top：本線程的候選堆，選定後按從好到差排序
+    size_t top_count;
+    size_t top_capacity;
+    size_t top_keep;             // 全局前 top_n 名中屬於本線程的項數（即 top 的前 top_keep 項）
+};
+
+// 一行的解碼結果
+typedef struct {
+    int status;                  // LINE_* / DECODE_FAILED / SUCCESS_NON_STANDARD_HASH / SUCCESS_STANDARD_HASH
+    size_t len;
+    uint64_t balance;            // 設置了 --min-balance 或 --top 時才解析
+    unsigned char bytes[64];
+} DecodedLine;
+
+/* -------------------------------------------------------------------------
+ * 6. 分階段批量解碼
+ * 每塊最多 DECODE_BLOCK 行，依次經過 Base58Check、Bech32、CashAddr、十六進制四個階段；
+ * 前三個階段先收集候選行再批量校驗（多緩衝區 SHA-256、多通道 polymod），
+ * 某行在某一階段解碼成功後不再進入後面的階段，與逐行按優先順序嘗試的結果一致。
+ * -------------------------------------------------------------------------*/
+#define DECODE_BLOCK 64
+
+typedef struct {
+    const char *addr;            // 指向輸入行內部的地址列
+    size_t len;
+    int fmts;                    // 尚待嘗試的格式，解碼成功後清零
+} PendingLine;
+
+// 各階段的臨時數據，階段之間依次復用
+typedef union {
+    struct {
+        uint8_t bin[DECODE_BLOCK][384];   // 地址最長 ADDRESS_MAX 字符，解碼後不超過 511 * 733 / 1000 + 1 = 375 字節
+        size_t bin_len[DECODE_BLOCK];
+    } b58;
+    Bech32Parsed bech32[DECODE_BLOCK];
+    CashAddrParsed cashaddr[DECODE_BLOCK];
+} DecodeScratch;
+
+static void set_decoded(DecodedLine *out, const unsigned char *bytes, size_t len)
+{
+    memcpy(out->bytes, bytes, len);
+    out->len = len;
+    out->status = len == 20 ? SUCCESS_STANDARD_HASH : SUCCESS_NON_STANDARD_HASH;
+}
+
+static void decode_stage_base58(PendingLine *pl, size_t m, DecodeScratch *sc, DecodedLine *out)
+{
+    size_t idx[DECODE_BLOCK];
+    const uint8_t *bins[DECODE_BLOCK];
+    uint8_t ok[DECODE_BLOCK];
+    size_t k = 0;
+    for (size_t j = 0; j < m; j++) {
+        if (!(pl[j].fmts & FMT_BASE58)) continue;
+        // payload（版本 + hash160）至少 21 字節，加上 4 字節校驗和
+        size_t bin_len = sizeof(sc->b58.bin[k]);
+        if (b58tobin_fast(sc->b58.bin[k], &bin_len, pl[j].addr, pl[j].len) && bin_len >= 24) {
+            bins[k] = sc->b58.bin[k];
+            sc->b58.bin_len[k] = bin_len;
+            idx[k++] = j;
+        }
+    }
+    b58check_verify_batch(bins, sc->b58.bin_len, k, ok);
+    for (size_t i = 0; i < k; i++) {
+        if (!ok[i]) continue;
+        set_decoded(&out[idx[i]], bins[i] + 1, 20);
+        pl[idx[i]].fmts = 0;
+    }
+}
+
+static void decode_stage_bech32(PendingLine *pl, size_t m, DecodeScratch *sc, DecodedLine *out)
+{
+    size_t idx[DECODE_BLOCK];
+    const uint8_t *values[DECODE_BLOCK];
+    size_t lens[DECODE_BLOCK];
+    uint32_t polymods[DECODE_BLOCK];
+    size_t k = 0;
+    for (size_t j = 0; j < m; j++) {
+        if (!(pl[j].fmts & FMT_BECH32)) continue;
+        if (bech32_parse(pl[j].addr, pl[j].len, &sc->bech32[k])) {
+            values[k] = sc->bech32[k].values;
+            lens[k] = sc->bech32[k].values_len;
+            idx[k++] = j;
+        }
+    }
+    bech32_polymod_batch(values, lens, k, polymods);
+    for (size_t i = 0; i < k; i++) {
+        unsigned char prog[40];
+        size_t prog_len = sizeof(prog);
+        int witver;
+        if (!is_segwit_hrp(sc->bech32[i].hrp) ||
+            !segwit_addr_decode_parsed(&sc->bech32[i], polymods[i], &witver, prog, &prog_len)) continue;
+        set_decoded(&out[idx[i]], prog, prog_len);
+        pl[idx[i]].fmts = 0;
+    }
+}
+
+static void decode_stage_cashaddr(PendingLine *pl, size_t m, DecodeScratch *sc, DecodedLine *out)
+{
+    size_t idx[DECODE_BLOCK];
+    const uint8_t *values[DECODE_BLOCK];
+    size_t lens[DECODE_BLOCK];
+    uint64_t polymods[DECODE_BLOCK];
+    size_t k = 0;
+    for (size_t j = 0; j < m; j++) {
+        if (!(pl[j].fmts & FMT_CASHADDR)) continue;
+        if (cashaddr_parse(pl[j].addr, pl[j].len, &sc->cashaddr[k]) == 0) {
+            values[k] = sc->cashaddr[k].values;
+            lens[k] = sc->cashaddr[k].values_len;
+            idx[k++] = j;
+        }
+    }
+    cashaddr_polymod_batch(values, lens, k, polymods);
+    for (size_t i = 0; i < k; i++) {
+        uint8_t version_byte;
+        unsigned char hash[64];
+        size_t hash_len = sizeof(hash);
+        if (decode_cashaddr_parsed_bin(&sc->cashaddr[i], polymods[i], &version_byte, hash, &hash_len) != 0) continue;
+        set_decoded(&out[idx[i]], hash, hash_len);
+        pl[idx[i]].fmts = 0;
+    }
+}
+
+static void decode_stage_hex(PendingLine *pl, size_t m, DecodedLine *out)
+{
+    for (size_t j = 0; j < m; j++) {
+        if (!(pl[j].fmts & FMT_HEX)) continue;
+        const char *addr = pl[j].addr;
+        size_t hex_start = (addr[0] == '0' && (addr[1] == 'x' || addr[1] == 'X')) ? 2 : 0;
+        unsigned char bytes[64];
+        int len = hex_decode(addr + hex_start, pl[j].len - hex_start, bytes, sizeof(bytes));
+        if (len > 0) {
+            set_decoded(&out[j], bytes, (size_t)len);
+        }
+    }
+}
+
+/*
+ * 按 fmt 取出地址列（及餘額列）並解碼 lines[0..n) 到 out[0..n)。
+ * 餘額低於 --min-balance 的行標記為 LINE_FILTERED，不進入任何解碼階段。
+ */
+static void decode_lines(const LineView *lines, size_t n, const InputFormat *fmt, DecodedLine *out)
+{
+    PendingLine pl[DECODE_BLOCK];
+    DecodeScratch sc;
+    bool need_balance = fmt->min_balance_set || fmt->top_n > 0;
+
+    for (size_t base = 0; base < n; base += DECODE_BLOCK) {
+        size_t m = n - base < DECODE_BLOCK ? n - base : DECODE_BLOCK;
+        for (size_t j = 0; j < m; j++) {
+            DecodedLine *o = &out[base + j];
+            o->status = DECODE_FAILED;
+            o->balance = 0;
+            pl[j].fmts = 0;
+            if (need_balance) {
+                const char *b;
+                size_t blen = line_column(&lines[base + j], fmt->balance_column, &b);
+                if (!parse_balance(b, blen, &o->balance)) o->balance = 0;
+                if (fmt->min_balance_set && o->balance < fmt->min_balance) {
+                    o->status = LINE_FILTERED;
+                    continue;
+                }
+            }
+            pl[j].len = line_column(&lines[base + j], fmt->address_column, &pl[j].addr);
+            if (pl[j].len > 0 && pl[j].len <= ADDRESS_MAX) {
+                pl[j].fmts = classify_address(pl[j].addr, pl[j].len);
+            }
+        }
+        decode_stage_base58(pl, m, &sc, out + base);
+        decode_stage_bech32(pl, m, &sc, out + base);
+        decode_stage_cashaddr(pl, m, &sc, out + base);
+        decode_stage_hex(pl, m, out + base);
+    }
+}
+
+static int worker_barrier_init(WorkerBarrier *b, int count)
+{
+    if (pthread_mutex_init(&b->mutex, NULL) != 0) return -1;
+    if (pthread_cond_init(&b->cond, NULL) != 0) {
+        pthread_mutex_destroy(&b->mutex);
+        return -1;
+    }
+    b->count = count;
+    b->waiting = 0;
+    b->phase = 0;
+    return 0;
+}
+
+static void worker_barrier_destroy(WorkerBarrier *b)
+{
+    pthread_cond_destroy(&b->cond);
+    pthread_mutex_destroy(&b->mutex);
+}
+
+// 調用者已持有 mutex：到齊則進入下一階段並喚醒所有等待者
+static void worker_barrier_release_locked(WorkerBarrier *b)
+{
+    if (b->waiting > 0 && b->waiting >= b->count) {
+        b->waiting = 0;
+        b->phase++;
+        pthread_cond_broadcast(&b->cond);
+    }
+}
+
+static void worker_barrier_wait(WorkerBarrier *b)
+{
+    pthread_mutex_lock(&b->mutex);
+    unsigned long phase = b->phase;
+    b->waiting++;
+    worker_barrier_release_locked(b);
+    while (phase == b->phase) {
+        pthread_cond_wait(&b->cond, &b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+}
+
+static void worker_barrier_shrink(WorkerBarrier *b, int count)
+{
+    pthread_mutex_lock(&b->mutex);
+    b->count = count;
+    worker_barrier_release_locked(b);
+    pthread_mutex_unlock(&b->mutex);
+}
+
+static void sort_shared_fail(SortShared *sh)
+{
+    pthread_mutex_lock(&sh->barrier.mutex);
+    sh->failed = true;
+    pthread_mutex_unlock(&sh->barrier.mutex);
+}
+
+/*
+ * 歸併本線程負責的區間 [splitters[id-1], splitters[id])：在每個線程的已排序數據中
+ * 二分查找區間邊界，再做 k 路歸併並去重。相同的鍵總落在同一區間，各區間按順序拼接即為全局結果。
+ */
+static void merge_partition(ThreadData *data)
+{
+    SortShared *sh = data->shared;
+    int k = sh->thread_count;
+    const unsigned char **runs = (const unsigned char **)malloc(k * sizeof(*runs));
+    size_t *lens = (size_t *)malloc(k * sizeof(*lens));
+    if (!runs || !lens) {
+        free(runs); free(lens);
+        sort_shared_fail(sh);
+        return;
+    }
+
+    size_t total = 0;
+    for (int r = 0; r < k; r++) {
+        const ThreadData *w = &sh->workers[r];
+        size_t lo = data->id == 0 ? 0
+                  : hash160_lower_bound(w->run, w->run_count, sh->splitters + (data->id - 1) * HASH160_SIZE);
+        size_t hi = data->id == k - 1 ? w->run_count
+                  : hash160_lower_bound(w->run, w->run_count, sh->splitters + data->id * HASH160_SIZE);
+        runs[r] = w->run + lo * HASH160_SIZE;
+        lens[r] = hi - lo;
+        total += hi - lo;
+    }
+
+    if (total > 0) {
+        data->merged = (unsigned char *)malloc(total * HASH160_SIZE);
+        size_t n = data->merged ? hash160_merge_unique(runs, lens, k, data->merged) : (size_t)-1;
+        if (n == (size_t)-1) {
+            sort_shared_fail(sh);
+        } else {
+            data->merged_count = n;
+        }
+    }
+    free(runs);
+    free(lens);
+}
+
+// 解碼 [start, end) 行並追加到本線程的標準哈希和旁表。返回 0 表示成功，-1 表示內存不足。
+static int decode_work_chunk(ThreadData *data, size_t start, size_t end)
+{
+    SortShared *sh = data->shared;
+    DecodedLine decoded[256];
+
+    if (sh->fmt->top_n == 0 && data->run_count + (end - start) > data->run_capacity) {
+        size_t capacity = data->run_capacity * 2;
+        if (capacity < data->run_count + (end - start)) capacity = data->run_count + (end - start);
+        unsigned char *temp = (unsigned char *)realloc(data->run, capacity * HASH160_SIZE);
+        if (!temp) return -1;
+        data->run = temp;
+        data->run_capacity = capacity;
+    }
+
+    for (size_t base = start; base < end; base += 256) {
+        size_t n = end - base < 256 ? end - base : 256;
+        decode_lines(sh->lines + base, n, sh->fmt, decoded);
+
+        for (size_t j = 0; j < n; j++) {
+            sh->status[base + j] = (signed char)decoded[j].status;
+            if (decoded[j].status == SUCCESS_STANDARD_HASH) {
+                if (sh->fmt->top_n > 0) {
+                    TopEntry e;
+                    e.balance = decoded[j].balance;
+                    e.line = base + j;
+                    memcpy(e.hash, decoded[j].bytes, HASH160_SIZE);
+                    if (top_heap_push(&data->top, &data->top_count, &data->top_capacity, sh->fmt->top_n, &e) != 0) return -1;
+                    continue;
+                }
+                memcpy(data->run + data->run_count * HASH160_SIZE, decoded[j].bytes, HASH160_SIZE);
+                data->run_count++;
+                continue;
+            }
+            if (decoded[j].status == LINE_FILTERED) {
+                continue;
+            }
+            data->failed_count++;
+            if (decoded[j].status == SUCCESS_NON_STANDARD_HASH) {
+                if (data->nonstd_count == data->nonstd_capacity) {
+                    size_t capacity = data->nonstd_capacity ? data->nonstd_capacity * 2 : 256;
+                    NonStandardEntry *temp = (NonStandardEntry *)realloc(data->nonstd, capacity * sizeof(NonStandardEntry));
+                    if (!temp) return -1;
+                    data->nonstd = temp;
+                    data->nonstd_capacity = capacity;
+                }
+                NonStandardEntry *e = &data->nonstd[data->nonstd_count++];
+                e->len = (unsigned char)(decoded[j].len < NON_STANDARD_MAX ? decoded[j].len : NON_STANDARD_MAX);
+                memcpy(e->bytes, decoded[j].bytes, e->len);
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * 線程處理函數：不斷原子領取下一個調度塊解碼，直到所有塊領完，再排序本線程收集的標準哈希。
+ * 每行的開銷差別很大（P2PKH 一次 Base58 解碼即可，無效行要走完所有解碼器），
+ * 按塊動態領取使各線程的結束時間接近總工作量的平均值。
+ * 所有線程到齊後由 0 號線程抽樣選出分割點，再由同一批線程各自歸併一個區間。
+ */
+void* thread_process(void *arg)
+{
+    ThreadData *data = (ThreadData*)arg;
+    SortShared *sh = data->shared;
+
+    // 先綁核再分配本線程的緩衝區，使其落在本地 NUMA 節點
+    affinity_pin_worker(data->id);
+
+    for (;;) {
+        size_t c = __atomic_fetch_add(&sh->next_chunk, 1, __ATOMIC_RELAXED);
+        if (c >= sh->chunk_count) break;
+        size_t start = c * sh->chunk_lines;
+        size_t end = start + sh->chunk_lines < sh->line_count ? start + sh->chunk_lines : sh->line_count;
+        sh->chunks[c].worker = data->id;
+        sh->chunks[c].nonstd_start = data->nonstd_count;
+        if (decode_work_chunk(data, start, end) != 0) {
+            sort_shared_fail(sh);
+            break;
+        }
+    }
+
+    if (sh->fmt->top_n > 0) {
+        // 各線程把自己的候選排好序，0 號線程從各線程的隊首依次取出全局前 top_n 名
+        qsort(data->top, data->top_count, sizeof(TopEntry), top_entry_compare);
+        worker_barrier_wait(&sh->barrier);
+        if (sh->failed) return NULL;
+        if (data->id == 0) {
+            for (int t = 0; t < sh->thread_count; t++) sh->workers[t].top_keep = 0;
+            for (size_t k = 0; k < sh->fmt->top_n; k++) {
+                ThreadData *best = NULL;
+                for (int t = 0; t < sh->thread_count; t++) {
+                    ThreadData *w = &sh->workers[t];
+                    if (w->top_keep < w->top_count &&
+                        (!best || top_entry_better(&w->top[w->top_keep], &best->top[best->top_keep]))) {
+                        best = w;
+                    }
+                }
+                if (!best) break;
+                best->top_keep++;
+            }
+        }
+        worker_barrier_wait(&sh->barrier);
+        if (sh->failed) return NULL;
+        data->run = (unsigned char *)malloc(data->top_keep ? data->top_keep * HASH160_SIZE : 1);
+        if (!data->run) {
+            sort_shared_fail(sh);
+        } else {
+            for (size_t k = 0; k < data->top_keep; k++) {
+                memcpy(data->run + k * HASH160_SIZE, data->top[k].hash, HASH160_SIZE);
+            }
+            data->run_count = data->top_keep;
+        }
+    }
+    hash160_sort(data->run, data->run_count);
+
+    worker_barrier_wait(&sh->barrier);
+    if (sh->failed) return NULL;
+
+    if (data->id == 0 && sh->thread_count > 1) {
+        const unsigned char **runs = (const unsigned char **)malloc(sh->thread_count * sizeof(*runs));
+        size_t *lens = (size_t *)malloc(sh->thread_count * sizeof(*lens));
+        if (runs && lens) {
+            for (int r = 0; r < sh->thread_count; r++) {
+                runs[r] = sh->workers[r].run;
+                lens[r] = sh->workers[r].run_count;
+            }
+        }
+        if (!runs || !lens ||
+            hash160_pick_splitters(runs, lens, sh->thread_count, sh->thread_count, sh->splitters) != 0) {
+            sort_shared_fail(sh);
+        }
+        free(runs);
+        free(lens);
+    }
+
+    worker_barrier_wait(&sh->barrier);
+    if (sh->failed) return NULL;
+
+    merge_partition(data);
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * 7. 流式處理模式：讀取線程 → 解碼線程 → 按輸入順序寫出，內存由在途塊數限定
+ * -------------------------------------------------------------------------*/
+
+typedef struct {
+    const InputFormat *fmt;
+    FILE *fout_failure;
+    unsigned char *hashes;       // 標準 hash160 的二進制數組，每個 20 字節
+    size_t hash_count;
+    size_t hash_capacity;
+    size_t hash_limit;           // hashes 最多容納的鍵數，滿了先就地去重，仍超過一半則排序後寫入 runs
+    const char *spill_prefix;    // 臨時文件的路徑前綴（即輸出前綴）
+    RunFile runs;                // 已寫出的有序段；runs.fp 為 NULL 表示尚未寫出過
+    size_t success_count;        // 成功解碼的行數（含重複）
+    TopEntry *top;               // --top：寫出線程按輸入順序收集的候選堆
+    size_t top_count;
+    size_t top_capacity;
+    size_t total_count;
+    size_t failed_count;
+} StreamContext;
+
+static void stream_process_chunk(StreamChunk *chunk, void *ctx)
+{
+    const StreamContext *sc = (const StreamContext *)ctx;
+    DecodedLine *results = (DecodedLine *)chunk->results;
+    size_t skip = 0;
+    if (sc->fmt->skip_header && chunk->seq == 0 && chunk->count > 0) {
+        results[0].status = LINE_HEADER;
+        skip = 1;
+    }
+    decode_lines(chunk->lines + skip, chunk->count - skip, sc->fmt, results + skip);
+}
+
+/*
+ * hashes 已滿：排序去重後若只剩不到一半（重複很多）就繼續在內存中收集，
+ * 否則作為一段有序數據寫入臨時文件並清空，收集的內存始終不超過 hash_limit 個鍵。
+ */
+static int stream_flush_hashes(StreamContext *sc)
+{
+    hash160_sort(sc->hashes, sc->hash_count);
+    sc->hash_count = hash160_dedup(sc->hashes, sc->hash_count);
+    if (sc->hash_count <= sc->hash_limit / 2) {
+        return 0;
+    }
+    if (!sc->runs.fp && run_file_open(&sc->runs, sc->spill_prefix) != 0) {
+        perror("無法創建排序臨時文件");
+        return -1;
+    }
+    if (run_file_append(&sc->runs, sc->hashes, sc->hash_count) != 0) {
+        perror("寫入排序臨時文件失敗");
+        return -1;
+    }
+    sc->hash_count = 0;
+    return 0;
+}
+
+static int stream_emit_chunk(StreamChunk *chunk, void *ctx)
+{
+    StreamContext *sc = (StreamContext *)ctx;
+    const DecodedLine *results = (const DecodedLine *)chunk->results;
+    char hex[65];
+
+    for (size_t i = 0; i < chunk->count; i++) {
+        if (results[i].status == LINE_HEADER) {
+            continue;
+        }
+        sc->total_count++;
+        if (results[i].status == LINE_FILTERED) {
+            continue;
+        }
+        if (results[i].status == SUCCESS_STANDARD_HASH && sc->fmt->top_n > 0) {
+            TopEntry e;
+            e.balance = results[i].balance;
+            e.line = sc->total_count;
+            memcpy(e.hash, results[i].bytes, HASH160_SIZE);
+            if (top_heap_push(&sc->top, &sc->top_count, &sc->top_capacity, sc->fmt->top_n, &e) != 0) {
+                fprintf(stderr, "內存分配失敗 (結果收集)。\n");
+                return -1;
+            }
+            continue;
+        }
+        if (results[i].status == SUCCESS_STANDARD_HASH) {
+            if (sc->hash_count >= sc->hash_capacity) {
+                if (sc->hash_capacity < sc->hash_limit) {
+                    size_t capacity = sc->hash_capacity ? sc->hash_capacity * 2 : 1 << 16;
+                    if (capacity > sc->hash_limit) capacity = sc->hash_limit;
+                    unsigned char *temp = (unsigned char *)realloc(sc->hashes, capacity * HASH160_SIZE);
+                    if (!temp) {
+                        fprintf(stderr, "內存分配失敗 (結果收集)。\n");
+                        return -1;
+                    }
+                    sc->hashes = temp;
+                    sc->hash_capacity = capacity;
+                } else if (stream_flush_hashes(sc) != 0) {
+                    return -1;
+                }
+            }
+            memcpy(sc->hashes + sc->hash_count * HASH160_SIZE, results[i].bytes, HASH160_SIZE);
+            sc->hash_count++;
+            sc->success_count++;
+            continue;
+        }
+
+        if (results[i].status == DECODE_FAILED) {
+            fprintf(sc->fout_failure, "[DECODE_FAILED] ");
+        } else {
+            // 非標準哈希最多輸出 NON_STANDARD_MAX 字節，與普通模式一致
+            bytes_to_hex(results[i].bytes, results[i].len < NON_STANDARD_MAX ? results[i].len : NON_STANDARD_MAX, hex);
+            fprintf(sc->fout_failure, "[NON_STANDARD_HASH: %s] ", hex);
+        }
+        fwrite(chunk->lines[i].ptr, 1, chunk->lines[i].len, sc->fout_failure);
+        fputc('\n', sc->fout_failure);
+        sc->failed_count++;
+    }
+    return 0;
+}
+
+// 已排序去重的 hash160 集合（查詢、增量更新和集合運算的輸入）：
+// .h160 文件直接映射，文本成功文件解析後放在內存中
+typedef struct {
+    H160File file;
+    unsigned char *owned;
+    const unsigned char *records;
+    size_t count;
+} HashDb;
+
+static int hash_db_open(const char *path, HashDb *db)
+{
+    memset(db, 0, sizeof(*db));
+    if (h160_open(path, &db->file) == 0) {
+        if (db->file.record_size != HASH160_SIZE || !(db->file.flags & H160_FLAG_SORTED)) {
+            fprintf(stderr, "數據庫不是已排序的 hash160 文件: %s\n", path);
+            h160_close(&db->file);
+            return -1;
+        }
+        db->records = db->file.records;
+        db->count = (size_t)db->file.count;
+        return 0;
+    }
+    if (errno != EINVAL) {
+        perror("無法打開數據庫文件");
+        return -1;
+    }
+
+    // 不是 .h160 文件時按 <prefix>_success.txt 解析：每行一個 40 位十六進制 hash160
+    InputBuffer in;
+    if (input_load_file(path, &in) != 0) {
+        perror("無法打開數據庫文件");
+        return -1;
+    }
+    db->owned = (unsigned char *)malloc(in.count ? in.count * HASH160_SIZE : 1);
+    if (!db->owned) {
+        fprintf(stderr, "內存分配失敗。\n");
+        input_free(&in);
+        return -1;
+    }
+    for (size_t i = 0; i < in.count; i++) {
+        const char *buf;
+        size_t len = line_column(&in.lines[i], 0, &buf);
+        if (len == 0) continue;
+        if (hex_decode(buf, len, db->owned + db->count * HASH160_SIZE, HASH160_SIZE) != HASH160_SIZE) {
+            fprintf(stderr, "數據庫第 %zu 行不是 hash160: %s\n", i + 1, path);
+            input_free(&in);
+            free(db->owned);
+            return -1;
+        }
+        db->count++;
+    }
+    input_free(&in);
+
+    // decode 寫出的文件已排序去重；其他來源的文件在這裡補上
+    for (size_t i = 1; i < db->count; i++) {
+        if (memcmp(db->owned + (i - 1) * HASH160_SIZE, db->owned + i * HASH160_SIZE, HASH160_SIZE) >= 0) {
+            hash160_sort(db->owned, db->count);
+            db->count = hash160_dedup(db->owned, db->count);
+            break;
+        }
+    }
+    db->records = db->owned;
+    return 0;
+}
+
+static void hash_db_close(HashDb *db)
+{
+    if (db->owned) {
+        free(db->owned);
+    } else {
+        h160_close(&db->file);
+    }
+    memset(db, 0, sizeof(*db));
+}
+
+/*
+ * 逐條寫出有序的 hash160：文本格式每行一個十六進制值，.h160 格式先寫文件頭，關閉時回填記錄數。
+ * 先寫入 <path>.tmp，成功後再改名，輸出文件可以與正在映射的輸入文件同名。
+ */
+typedef struct {
+    FILE *fp;
+    bool h160;
+    bool failed;
+    uint64_t count;
+    char path[256];
+    char tmp_path[264];
+} HashWriter;
+
+// 打開 <base_name>_<name>.txt 或 .h160。返回 0 表示成功，-1 表示失敗（已輸出錯誤信息）。
+static int hash_writer_open(HashWriter *w, const char *base_name, const char *name, bool h160)
+{
+    memset(w, 0, sizeof(*w));
+    w->h160 = h160;
+    snprintf(w->path, sizeof(w->path), "%s_%s.%s", base_name, name, h160 ? "h160" : "txt");
+    snprintf(w->tmp_path, sizeof(w->tmp_path), "%s.tmp", w->path);
+    w->fp = fopen(w->tmp_path, h160 ? "wb" : "w");
+    if (!w->fp) {
+        fprintf(stderr, "無法打開輸出文件 %s: %s\n", w->tmp_path, strerror(errno));
+        return -1;
+    }
+    if (h160 && h160_write_header(w->fp, 0, HASH160_SIZE, H160_FLAG_SORTED | H160_FLAG_UNIQUE) != 0) {
+        w->failed = true;
+    }
+    return 0;
+}
+
+// 寫出 n 個連續存放的鍵
+static void hash_writer_put(HashWriter *w, const unsigned char *keys, size_t n)
+{
+    if (w->h160) {
+        if (fwrite(keys, HASH160_SIZE, n, w->fp) != n) w->failed = true;
+    } else {
+        char line[2 * HASH160_SIZE + 2];
+        for (size_t i = 0; i < n; i++) {
+            bytes_to_hex(keys + i * HASH160_SIZE, HASH160_SIZE, line);
+            line[2 * HASH160_SIZE] = '\n';
+            fwrite(line, 1, 2 * HASH160_SIZE + 1, w->fp);
+        }
+    }
+    w->count += n;
+}
+
+// 回填文件頭並改名為最終文件名。返回 0 表示成功，-1 表示失敗（已輸出錯誤信息並刪除臨時文件）。
+static int hash_writer_close(HashWriter *w)
+{
+    if (w->h160 && !w->failed) {
+        if (fseek(w->fp, 0, SEEK_SET) != 0 ||
+            h160_write_header(w->fp, w->count, HASH160_SIZE, H160_FLAG_SORTED | H160_FLAG_UNIQUE) != 0) {
+            w->failed = true;
+        }
+    }
+    if (ferror(w->fp)) w->failed = true;
+    if (fclose(w->fp) != 0) w->failed = true;
+    w->fp = NULL;
+    if (!w->failed && rename(w->tmp_path, w->path) != 0) {
+        w->failed = true;
+    }
+    if (w->failed) {
+        fprintf(stderr, "寫入輸出文件失敗: %s\n", w->path);
+        remove(w->tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// 由若干段依次拼接而成的有序去重序列上的遊標
+typedef struct {
+    const unsigned char *const *segs;
+    const size_t *counts;
+    int nsegs;
+    int seg;
+    size_t pos;
+} HashCursor;
+
+static void hash_cursor_init(HashCursor *c, const unsigned char *const segs[], const size_t counts[], int nsegs)
+{
+    c->segs = segs;
+    c->counts = counts;
+    c->nsegs = nsegs;
+    c->seg = 0;
+    c->pos = 0;
+}
+
+// 返回當前鍵，序列結束時返回 NULL
+static const unsigned char *hash_cursor_peek(HashCursor *c)
+{
+    while (c->seg < c->nsegs && c->pos >= c->counts[c->seg]) {
+        c->seg++;
+        c->pos = 0;
+    }
+    return c->seg < c->nsegs ? c->segs[c->seg] + c->pos * HASH160_SIZE : NULL;
+}
+
+#define MERGE_ONLY_A 0
+#define MERGE_ONLY_B 1
+#define MERGE_BOTH   2
+
+/*
+ * 一次順序歸併兩個有序去重序列。每個鍵屬於 MERGE_ONLY_A / MERGE_ONLY_B / MERGE_BOTH 之一：
+ * out_mask 的第 i 位為 1 時類別 i 寫入 out；only_a、only_b 非 NULL 時另外寫入對應類別的鍵。
+ * stats[i] 返回各類別的鍵數。
+ */
+static void merge_hash_sets(HashCursor *a, HashCursor *b, HashWriter *out, int out_mask,
+                            HashWriter *only_a, HashWriter *only_b, size_t stats[3])
+{
+    stats[0] = stats[1] = stats[2] = 0;
+    for (;;) {
+        const unsigned char *ka = hash_cursor_peek(a);
+        const unsigned char *kb = hash_cursor_peek(b);
+        if (!ka && !kb) break;
+
+        int cmp = !ka ? 1 : !kb ? -1 : memcmp(ka, kb, HASH160_SIZE);
+        int which = cmp < 0 ? MERGE_ONLY_A : cmp > 0 ? MERGE_ONLY_B : MERGE_BOTH;
+        const unsigned char *key = cmp <= 0 ? ka : kb;
+        if (cmp <= 0) a->pos++;
+        if (cmp >= 0) b->pos++;
+
+        stats[which]++;
+        if (out && (out_mask & (1 << which))) hash_writer_put(out, key, 1);
+        if (which == MERGE_ONLY_A && only_a) hash_writer_put(only_a, key, 1);
+        if (which == MERGE_ONLY_B && only_b) hash_writer_put(only_b, key, 1);
+    }
+}
+
+// 輸出相關的命令行選項
+typedef struct {
+    const char *base_name;       // 輸出文件前綴
+    bool h160;                   // 成功結果寫為二進制 <prefix>_success.h160，而不是十六進制文本
+    double bloom_fpr;            // 大於 0 時另寫 <prefix>_success.bloom，取值為目標誤判率
+    const char *base_path;       // 非 NULL 時與上次運行的已排序輸出合併，成功文件為兩者的並集
+    bool delta;                  // 與 base_path 合用：另寫 <prefix>_added 與 <prefix>_removed
+} OutputOptions;
+
+// 一個建過濾器線程負責的鍵：拼接後全局下標 [lo, hi)
+typedef struct {
+    Bloom *bloom;
+    const unsigned char *const *segs;
+    const size_t *counts;
+    int nsegs;
+    size_t lo;
+    size_t hi;
+} BloomTask;
+
+static void *bloom_build_thread(void *arg)
+{
+    BloomTask *task = (BloomTask *)arg;
+    size_t base = 0;
+    for (int s = 0; s < task->nsegs && base < task->hi; s++) {
+        size_t seg_lo = task->lo > base ? task->lo - base : 0;
+        size_t seg_hi = task->hi - base < task->counts[s] ? task->hi - base : task->counts[s];
+        if (seg_lo < seg_hi) {
+            bloom_add_keys(task->bloom, task->segs[s] + seg_lo * HASH160_SIZE, seg_hi - seg_lo);
+        }
+        base += task->counts[s];
+    }
+    return NULL;
+}
+
+/*
+ * 由已排序去重的各段建分塊布隆過濾器並寫出 <prefix>_success.bloom。
+ * 鍵按順序均分給各線程，同一塊可能被多個線程同時置位，bloom_add_keys 按字原子置位。
+ */
+static int write_bloom_file(const OutputOptions *opt, const unsigned char *const segs[],
+                            const size_t counts[], int nsegs, int thread_count)
+{
+    size_t total = 0;
+    for (int s = 0; s < nsegs; s++) total += counts[s];
+
+    Bloom bloom;
+    if (bloom_init(&bloom, total, opt->bloom_fpr) != 0) {
+        fprintf(stderr, "內存分配失敗 (布隆過濾器)。\n");
+        return -1;
+    }
+
+    pthread_t *threads = (pthread_t *)malloc(thread_count * sizeof(pthread_t));
+    BloomTask *tasks = (BloomTask *)malloc(thread_count * sizeof(BloomTask));
+    if (!threads || !tasks) {
+        fprintf(stderr, "內存分配失敗 (布隆過濾器)。\n");
+        free(threads); free(tasks);
+        bloom_free(&bloom);
+        return -1;
+    }
+    int started = 0;
+    for (int t = 0; t < thread_count; t++) {
+        tasks[t].bloom = &bloom;
+        tasks[t].segs = segs;
+        tasks[t].counts = counts;
+        tasks[t].nsegs = nsegs;
+        tasks[t].lo = total * (size_t)t / thread_count;
+        tasks[t].hi = total * (size_t)(t + 1) / thread_count;
+        if (pthread_create(&threads[t], NULL, bloom_build_thread, &tasks[t]) != 0) {
+            // 無法創建線程時由當前線程完成剩餘部分
+            tasks[t].hi = total;
+            bloom_build_thread(&tasks[t]);
+            break;
+        }
+        started++;
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    free(tasks);
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s_success.bloom", opt->base_name);
+    FILE *fout = fopen(path, "wb");
+    if (!fout) {
+        perror("無法打開布隆過濾器輸出文件");
+        bloom_free(&bloom);
+        return -1;
+    }
+    int ret = bloom_write(&bloom, fout);
+    if (fclose(fout) != 0) ret = -1;
+    if (ret != 0) {
+        fprintf(stderr, "寫入布隆過濾器文件失敗: %s\n", path);
+    } else {
+        printf("Bloom   filter : %llu blocks, k=%u, %zu bytes\n",
+               (unsigned long long)bloom.block_count, bloom.k, bloom.size + BLOOM_HEADER_SIZE);
+    }
+    bloom_free(&bloom);
+    return ret;
+}
+
+/*
+ * 寫出本次運行的全部結果文件。segs[0..nsegs) 是依次拼接後整體有序且已去重的若干段。
+ * 指定 base_path 時與舊輸出一次順序歸併：成功文件為並集，--delta 時另寫新增與消失的 hash160，
+ * 舊數據不重新排序。返回 0 表示成功，-1 表示失敗（已輸出錯誤信息）。
+ */
+static int write_outputs(const OutputOptions *opt, const unsigned char *const segs[],
+                         const size_t counts[], int nsegs, int thread_count)
+{
+    HashWriter success;
+    if (!opt->base_path) {
+        if (hash_writer_open(&success, opt->base_name, "success", opt->h160) != 0) return -1;
+        for (int s = 0; s < nsegs; s++) {
+            hash_writer_put(&success, segs[s], counts[s]);
+        }
+        if (hash_writer_close(&success) != 0) return -1;
+        return opt->bloom_fpr > 0 ? write_bloom_file(opt, segs, counts, nsegs, thread_count) : 0;
+    }
+
+    HashDb old;
+    if (hash_db_open(opt->base_path, &old) != 0) return -1;
+
+    HashWriter added, removed;
+    int ret = hash_writer_open(&success, opt->base_name, "success", opt->h160);
+    if (ret == 0 && opt->delta) {
+        ret = hash_writer_open(&added, opt->base_name, "added", opt->h160);
+        if (ret == 0 && hash_writer_open(&removed, opt->base_name, "removed", opt->h160) != 0) {
+            hash_writer_close(&added);
+            ret = -1;
+        }
+        if (ret != 0) hash_writer_close(&success);
+    }
+    if (ret != 0) {
+        hash_db_close(&old);
+        return -1;
+    }
+
+    HashCursor cur_new, cur_old;
+    hash_cursor_init(&cur_new, segs, counts, nsegs);
+    hash_cursor_init(&cur_old, &old.records, &old.count, 1);
+    size_t stats[3];
+    merge_hash_sets(&cur_new, &cur_old, &success, 7,
+                    opt->delta ? &added : NULL, opt->delta ? &removed : NULL, stats);
+    hash_db_close(&old);
+
+    if (hash_writer_close(&success) != 0) ret = -1;
+    if (opt->delta) {
+        if (hash_writer_close(&added) != 0) ret = -1;
+        if (hash_writer_close(&removed) != 0) ret = -1;
+    }
+    if (ret != 0) return -1;
+
+    printf("Merged with base: %zu (added %zu, removed %zu, unchanged %zu)\n",
+           stats[MERGE_ONLY_A] + stats[MERGE_ONLY_B] + stats[MERGE_BOTH],
+           stats[MERGE_ONLY_A], stats[MERGE_ONLY_B], stats[MERGE_BOTH]);
+
+    // 並集不在內存中：映射剛寫出的成功文件來建過濾器
+    if (opt->bloom_fpr > 0) {
+        HashDb merged;
+        if (hash_db_open(success.path, &merged) != 0) return -1;
+        ret = write_bloom_file(opt, &merged.records, &merged.count, 1, thread_count);
+        hash_db_close(&merged);
+    }
+    return ret;
+}
+
+// 流水線處理線程的初始化：按放置計劃綁核
+static void stream_worker_init(int index, void *ctx)
+{
+    (void)ctx;
+    affinity_pin_worker(index);
+}
+
+// decompress_close 失敗後按 errno 說明原因
+static void report_decompress_error(void)
+{
+    if (errno == ENOENT) {
+        fprintf(stderr, "找不到 zstd 命令，請確認它在 PATH 中（zstd not found on PATH）。\n");
+    } else {
+        fprintf(stderr, "壓縮輸入已損壞或不完整。\n");
+    }
+}
+
+// 流式模式收尾階段一個線程的任務：先排序一個切片，再歸併一個區間
+typedef struct {
+    unsigned char *slice;        // 排序階段：本線程負責的切片
+    size_t slice_count;
+    const unsigned char *const *runs;   // 歸併階段：k 路各自有序的數據
+    const size_t *lens;
+    size_t k;
+    const unsigned char *lo_key; // 區間下界（含），NULL 表示從頭開始
+    const unsigned char *hi_key; // 區間上界（不含），NULL 表示到末尾
+    unsigned char *out;          // 歸併結果的總緩衝區；本區間寫在各路區間起點之和的位置
+    const unsigned char *seg;    // 歸併結果
+    size_t seg_count;
+    bool failed;
+} FinalTask;
+
+static void *final_sort_thread(void *arg)
+{
+    FinalTask *task = (FinalTask *)arg;
+    hash160_sort(task->slice, task->slice_count);
+    return NULL;
+}
+
+static void *final_merge_thread(void *arg)
+{
+    FinalTask *task = (FinalTask *)arg;
+    const unsigned char **runs = (const unsigned char **)malloc(task->k * sizeof(*runs));
+    size_t *lens = (size_t *)malloc(task->k * sizeof(*lens));
+    if (!runs || !lens) {
+        free(runs); free(lens);
+        task->failed = true;
+        return NULL;
+    }
+    // 各路中本區間之前的鍵數之和就是本區間結果的起點，各區間互不重疊
+    size_t offset = 0;
+    for (size_t r = 0; r < task->k; r++) {
+        size_t lo = task->lo_key ? hash160_lower_bound(task->runs[r], task->lens[r], task->lo_key) : 0;
+        size_t hi = task->hi_key ? hash160_lower_bound(task->runs[r], task->lens[r], task->hi_key) : task->lens[r];
+        runs[r] = task->runs[r] + lo * HASH160_SIZE;
+        lens[r] = hi - lo;
+        offset += lo;
+    }
+    unsigned char *out = task->out + offset * HASH160_SIZE;
+    size_t n = hash160_merge_unique(runs, lens, task->k, out);
+    if (n == (size_t)-1) {
+        task->failed = true;
+    } else {
+        task->seg = out;
+        task->seg_count = n;
     }
-    hex_str[len * 2] = '\0';
+    free(runs);
+    free(lens);
+    return NULL;
 }
 
-/* -------------------------------------------------------------------------
- * 2. 輔助函數：將十六進制字符串轉換為字節數組 
- * -------------------------------------------------------------------------*/
-static int hex_to_bytes(const char *hex_str, unsigned char *bytes_out, size_t max_len) {
-    size_t len = strlen(hex_str);
-    if (len % 2 != 0) {
-        return 0;
+// 在 count 個線程上運行 fn(tasks[i])；無法創建線程時由當前線程完成餘下的任務
+static void run_final_tasks(void *(*fn)(void *), FinalTask *tasks, int count)
+{
+    pthread_t *threads = (pthread_t *)malloc(count * sizeof(pthread_t));
+    int started = 0;
+    while (threads && started < count && pthread_create(&threads[started], NULL, fn, &tasks[started]) == 0) {
+        started++;
     }
-    size_t bytes_len = len / 2;
-    if (bytes_len > max_len) {
-        return 0;
+    for (int t = started; t < count; t++) {
+        fn(&tasks[t]);
     }
-    for (size_t i = 0; i < bytes_len; i++) {
-        unsigned int val;
-        if (sscanf(hex_str + (i * 2), "%2x", &val) != 1) {
-            return 0;
-        }
-        bytes_out[i] = (unsigned char)val;
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
     }
-    return (int)bytes_len;
+    free(threads);
 }
 
-/* -------------------------------------------------------------------------
- * 3. 去除行首尾空白 
- * -------------------------------------------------------------------------*/
-static void trim_whitespace(char *s)
+/*
+ * 流式模式的收尾：把 hashes 切成若干片並行排序；沒有寫出過臨時段時各片就是歸併的各路，
+ * 否則各片也寫入臨時文件，與之前的段一起映射後作為各路。然後抽樣選出分割點，
+ * thread_count 個線程各歸併去重一個區間，各區間依次拼接即為最終結果，交給 write_outputs。
+ * 返回 0 表示成功，-1 表示失敗（已輸出錯誤信息）。
+ */
+static int finish_stream_hashes(StreamContext *sc, const OutputOptions *opt, int thread_count)
 {
-    size_t l = strlen(s);
-    while(l > 0 && isspace((unsigned char)s[l-1])){
-        s[--l] = 0;
+    // 切片太小時少用幾個線程排序，避免大量空的歸併路
+    int slices = thread_count;
+    if ((size_t)slices > sc->hash_count / 4096 + 1) slices = (int)(sc->hash_count / 4096 + 1);
+
+    FinalTask *tasks = (FinalTask *)calloc(thread_count, sizeof(FinalTask));
+    unsigned char *splitters = (unsigned char *)malloc(thread_count * HASH160_SIZE);
+    const unsigned char **runs = NULL;
+    size_t *lens = NULL;
+    const unsigned char **segs = NULL;
+    size_t *counts = NULL;
+    unsigned char *out = NULL;
+    int ret = -1;
+    if (!tasks || !splitters) {
+        fprintf(stderr, "內存分配失敗 (排序歸併)。\n");
+        goto done;
     }
-    int start = 0;
-    while(s[start] && isspace((unsigned char)s[start])){
-        start++;
+
+    for (int t = 0; t < slices; t++) {
+        size_t lo = sc->hash_count * (size_t)t / slices, hi = sc->hash_count * (size_t)(t + 1) / slices;
+        tasks[t].slice = sc->hashes + lo * HASH160_SIZE;
+        tasks[t].slice_count = hi - lo;
     }
-    if(start > 0){
-        memmove(s, s + start, l + 1 - start);
+    run_final_tasks(final_sort_thread, tasks, slices);
+
+    size_t k = (size_t)slices;
+    if (sc->runs.fp) {
+        for (int t = 0; t < slices; t++) {
+            if (run_file_append(&sc->runs, tasks[t].slice, tasks[t].slice_count) != 0) {
+                perror("寫入排序臨時文件失敗");
+                goto done;
+            }
+        }
+        free(sc->hashes);
+        sc->hashes = NULL;
+        // 結果寫在同一文件的末尾，超出內存時由頁面緩存換出
+        if (run_file_map(&sc->runs, sc->runs.key_count) != 0) {
+            perror("無法映射排序臨時文件");
+            goto done;
+        }
+        k = sc->runs.run_count;
+        out = sc->runs.base + sc->runs.key_count * HASH160_SIZE;
+    } else {
+        out = (unsigned char *)malloc(sc->hash_count ? sc->hash_count * HASH160_SIZE : 1);
     }
-}
 
-/* -------------------------------------------------------------------------
- * 4. decode_address_general 
- * -------------------------------------------------------------------------*/
-static int decode_address_general(const char *addr_str, unsigned char *out_bytes, size_t *out_len) {
-    unsigned char temp_decoded_buf[64];
-    size_t current_len = 0;
-    int witver;
-
-    uint8_t *b58_payload = base58_decode_check(addr_str, &current_len);
-    if (b58_payload) {
-        if (current_len >= 20) {
-            memcpy(out_bytes, b58_payload + 1, 20);
-            *out_len = 20;
-            free(b58_payload);
-            return 1;
+    runs = (const unsigned char **)malloc(k * sizeof(*runs));
+    lens = (size_t *)malloc(k * sizeof(*lens));
+    segs = (const unsigned char **)malloc(thread_count * sizeof(*segs));
+    counts = (size_t *)malloc(thread_count * sizeof(*counts));
+    if (!out || !runs || !lens || !segs || !counts) {
+        fprintf(stderr, "內存分配失敗 (排序歸併)。\n");
+        goto done;
+    }
+    for (size_t r = 0; r < k; r++) {
+        if (sc->runs.fp) {
+            runs[r] = run_file_run(&sc->runs, r, &lens[r]);
+        } else {
+            runs[r] = tasks[r].slice;
+            lens[r] = tasks[r].slice_count;
         }
-        free(b58_payload);
     }
 
-    const char *hrps[] = {"bc", "tb", "ltc", "tltc", "btg", NULL};
-    for (int i = 0; hrps[i] != NULL; ++i) {
-        size_t segwit_prog_len_val = sizeof(temp_decoded_buf);
-        if (segwit_addr_decode(addr_str, hrps[i], &witver, temp_decoded_buf, &segwit_prog_len_val)) {
-            memcpy(out_bytes, temp_decoded_buf, segwit_prog_len_val);
-            *out_len = segwit_prog_len_val;
-            return 1;
+    if (hash160_pick_splitters(runs, lens, k, thread_count, splitters) != 0) {
+        fprintf(stderr, "內存分配失敗 (排序歸併)。\n");
+        goto done;
+    }
+    for (int t = 0; t < thread_count; t++) {
+        tasks[t].runs = runs;
+        tasks[t].lens = lens;
+        tasks[t].k = k;
+        tasks[t].lo_key = t == 0 ? NULL : splitters + (t - 1) * HASH160_SIZE;
+        tasks[t].hi_key = t == thread_count - 1 ? NULL : splitters + t * HASH160_SIZE;
+        tasks[t].out = out;
+    }
+    run_final_tasks(final_merge_thread, tasks, thread_count);
+
+    for (int t = 0; t < thread_count; t++) {
+        if (tasks[t].failed) {
+            fprintf(stderr, "內存分配失敗 (排序歸併)。\n");
+            goto done;
         }
+        segs[t] = tasks[t].seg;
+        counts[t] = tasks[t].seg_count;
     }
+    ret = write_outputs(opt, segs, counts, thread_count, thread_count);
 
-    CashAddrResult cash_result;
-    if (decode_cashaddr(addr_str, &cash_result) == 0) {
-        current_len = hex_to_bytes(cash_result.hash160, out_bytes, 20);
-        if (current_len == 20) {
-            *out_len = 20;
+done:
+    if (!sc->runs.fp) free(out);
+    free(runs);
+    free(lens);
+    free(segs);
+    free(counts);
+    free(splitters);
+    free(tasks);
+    return ret;
+}
+
+static int run_stream_mode(Decompressor *dz, const OutputOptions *opt, const InputFormat *fmt,
+                           int thread_count, size_t chunk_size, int max_chunks)
+{
+    char outFileFailurePath[256];
+    snprintf(outFileFailurePath, sizeof(outFileFailurePath), "%s_failure.txt", opt->base_name);
+
+    StreamContext sc;
+    memset(&sc, 0, sizeof(sc));
+    sc.fmt = fmt;
+    // 收集 hash160 的內存與流水線的輸入預算相同
+    sc.hash_limit = chunk_size * (size_t)max_chunks / HASH160_SIZE;
+    if (sc.hash_limit < (1u << 16)) sc.hash_limit = 1u << 16;
+    sc.spill_prefix = opt->base_name;
+    sc.fout_failure = fopen(outFileFailurePath, "w");
+    if (!sc.fout_failure) {
+        perror("無法打開失敗輸出文件");
+        return 1;
+    }
+
+    StreamConfig cfg;
+    cfg.chunk_size = chunk_size;
+    cfg.max_chunks = max_chunks;
+    cfg.worker_count = thread_count;
+    cfg.prefix = dz->format == DECOMPRESS_NONE ? dz->prefix : NULL;
+    cfg.prefix_len = dz->format == DECOMPRESS_NONE ? dz->prefix_len : 0;
+    cfg.result_size = sizeof(DecodedLine);
+    cfg.process = stream_process_chunk;
+    cfg.emit = stream_emit_chunk;
+    cfg.worker_init = stream_worker_init;
+    cfg.ctx = &sc;
+
+    int ret = stream_run(dz->fp, &cfg);
+    fclose(sc.fout_failure);
+    // 解壓出錯時讀取線程只看到提前結束，在寫出結果之前檢查
+    if (decompress_close(dz) != 0 && ret == 0) {
+        report_decompress_error();
+        ret = -1;
+    }
+    if (ret != 0) {
+        fprintf(stderr, "流式處理失敗。\n");
+        free(sc.hashes);
+        free(sc.top);
+        run_file_close(&sc.runs);
+        return 1;
+    }
+    if (sc.total_count == 0) {
+        fprintf(stderr, "輸入文件/標準輸入為空或無有效行。\n");
+        free(sc.hashes);
+        free(sc.top);
+        run_file_close(&sc.runs);
+        return 1;
+    }
+    if (fmt->top_n > 0) {
+        sc.hashes = (unsigned char *)malloc(sc.top_count ? sc.top_count * HASH160_SIZE : 1);
+        if (!sc.hashes) {
+            fprintf(stderr, "內存分配失敗 (結果收集)。\n");
+            free(sc.top);
             return 1;
         }
+        for (size_t i = 0; i < sc.top_count; i++) {
+            memcpy(sc.hashes + i * HASH160_SIZE, sc.top[i].hash, HASH160_SIZE);
+        }
+        sc.hash_count = sc.top_count;
+        sc.success_count = sc.top_count;
+        free(sc.top);
     }
 
-    if (strncmp(addr_str, "0x", 2) == 0 || strncmp(addr_str, "0X", 2) == 0) {
-        current_len = hex_to_bytes(addr_str + 2, out_bytes, sizeof(temp_decoded_buf));
-    } else {
-        current_len = hex_to_bytes(addr_str, out_bytes, sizeof(temp_decoded_buf));
+    int wret = finish_stream_hashes(&sc, opt, thread_count);
+    free(sc.hashes);
+    run_file_close(&sc.runs);
+    if (wret != 0) {
+        return 1;
+    }
+
+    printf("Total  quantity: %zu\n", sc.total_count);
+    printf("Hash160 Success: %zu (Deduplicated and sorted)\n", sc.success_count);
+    printf("Hash160  failed: %zu\n", sc.failed_count);
+    if (fmt->min_balance_set || fmt->top_n > 0) {
+        printf("Filtered  lines: %zu\n", sc.total_count - sc.success_count - sc.failed_count);
+    }
+    return 0;
+}
+
+// 解析帶 K/M/G 後綴的字節數；負數、溢出和多餘字符都視為無效
+static bool parse_size(const char *s, size_t *out) {
+    if (*s < '0' || *s > '9') return false;
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (errno == ERANGE) return false;
+    int shift = 0;
+    switch (*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+        default: break;
     }
+    if (*end != '\0' || v > (SIZE_MAX >> shift)) return false;
+    *out = (size_t)v << shift;
+    return true;
+}
+
+// 解析 [min, max] 範圍內的十進制整數，不接受後綴或其他多餘字符
+static bool parse_count(const char *s, unsigned long long min, unsigned long long max, unsigned long long *out) {
+    if (*s < '0' || *s > '9') return false;
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*end != '\0' || errno == ERANGE || v < min || v > max) return false;
+    *out = v;
+    return true;
+}
+
+// 線程數與 CPU 放置選項，主模式和查詢模式共用
+typedef struct {
+    int threads;        // 0 表示使用全部可用 CPU
+    int reserve;        // 留給同機其他服務的 CPU 數
+    bool pin;
+} ThreadOptions;
 
-    if (current_len > 0) {
-        *out_len = current_len;
+// argv[*i] 是線程選項時解析它（及其參數）並返回 1，不是時返回 0，參數無效時返回 -1
+static int parse_thread_option(int argc, char *argv[], int *i, ThreadOptions *opt) {
+    if (strcmp(argv[*i], "--affinity") == 0) {
+        opt->pin = true;
         return 1;
     }
+    bool is_threads = strcmp(argv[*i], "-t") == 0;
+    if (!is_threads && strcmp(argv[*i], "--reserve-cores") != 0) {
+        return 0;
+    }
+    if (*i + 1 >= argc) {
+        return 0;
+    }
+    char *end;
+    long v = strtol(argv[++*i], &end, 10);
+    if (*end != '\0' || v < (is_threads ? 1 : 0) || v > 4096) {
+        fprintf(stderr, "無效的%s: %s\n", is_threads ? "線程數" : "保留核心數", argv[*i]);
+        return -1;
+    }
+    if (is_threads) {
+        opt->threads = (int)v;
+    } else {
+        opt->reserve = (int)v;
+    }
+    return 1;
+}
 
-    return 0;
+// 按選項建立 CPU 放置計劃並返回工作線程數，失敗時返回 0
+static int resolve_thread_count(const ThreadOptions *opt) {
+    int cpus = affinity_configure(opt->reserve, opt->pin);
+    if (cpus < 0) {
+        if (errno == EINVAL) {
+            fprintf(stderr, "保留核心數 %d 不小於可用的 CPU 數。\n", opt->reserve);
+        } else if (errno == ENOSYS) {
+            fprintf(stderr, "此平台不支持 --affinity。\n");
+        } else {
+            perror("無法設置 CPU 親和性");
+        }
+        return 0;
+    }
+    return opt->threads > 0 ? opt->threads : cpus;
 }
 
 /* -------------------------------------------------------------------------
- * 5. 线程相關結構和變量
+ * 8. 查詢模式：在已排序的輸出上逐行查詢地址、hash160、前綴或範圍
  * -------------------------------------------------------------------------*/
 
-#define DECODE_FAILED            -1
-#define SUCCESS_NON_STANDARD_HASH 0
-#define SUCCESS_STANDARD_HASH     1
+#define QUERY_INVALID 0
+#define QUERY_EXACT   1
+#define QUERY_PREFIX  2
+#define QUERY_RANGE   3
 
 
+// 一行查詢的結果
 typedef struct {
-    char output_hex_str[65];     
-    int status;                  
-    size_t original_line_index;  
-} ProcessedResult;
+    int kind;                    // QUERY_*
+    unsigned char key[HASH160_SIZE];
+    size_t lo;                   // 命中記錄的區間 [lo, hi)，精確查詢命中時 hi = lo + 1
+    size_t hi;
+} QueryResult;
 
-// ThreadData 結構用於傳遞給每個線程的數據 
 typedef struct {
-    char **lines;
-    size_t start;
-    size_t end;
-    ProcessedResult *results;
-} ThreadData;
+    const HashDb *db;
+    bool list;                   // 前綴/範圍查詢時逐條列出命中的記錄
+    FILE *out;
+    size_t queries;
+    size_t hits;
+    size_t invalid;
+} QueryContext;
 
-// 線程處理函數
-void* thread_process(void *arg)
+
+/*
+ * 把 1 到 40 位十六進制前綴補成完整的鍵：fill 為 0x0 時得到前綴下的最小鍵，為 0xf 時得到最大鍵。
+ * 成功返回 1，含非十六進制字符或長度不合法時返回 0。
+ */
+static int hex_prefix_to_key(const char *hex, size_t len, int fill, unsigned char key[HASH160_SIZE])
 {
-    ThreadData *data = (ThreadData*)arg;
-    for(size_t i = data->start; i < data->end; i++){
-        char *full_line = data->lines[i];
-
-        data->results[i].original_line_index = i;
-        
-        char address_part_buffer[512];
-
-        char *tab_pos = strchr(full_line, '\t');
-        if (tab_pos) {
-            size_t addr_len = tab_pos - full_line;
-            if (addr_len >= sizeof(address_part_buffer)) {
-                data->results[i].status = DECODE_FAILED; 
+    char buf[2 * HASH160_SIZE];
+    if (len == 0 || len > sizeof(buf)) return 0;
+    memcpy(buf, hex, len);
+    memset(buf + len, fill ? 'f' : '0', sizeof(buf) - len);
+    return hex_decode(buf, sizeof(buf), key, HASH160_SIZE) == HASH160_SIZE;
+}
+
+// 解析 "prefix:<hex>" 或 "range:<hex>-<hex>"（兩端均包含）；不是這兩種語法時返回 0
+static int parse_query_range(const char *line, size_t len, const HashDb *db, QueryResult *r)
+{
+    unsigned char lo_key[HASH160_SIZE], hi_key[HASH160_SIZE];
+    if (len > 7 && memcmp(line, "prefix:", 7) == 0) {
+        r->kind = QUERY_INVALID;
+        if (!hex_prefix_to_key(line + 7, len - 7, 0, lo_key) ||
+            !hex_prefix_to_key(line + 7, len - 7, 1, hi_key)) return 1;
+        r->kind = QUERY_PREFIX;
+    } else if (len > 6 && memcmp(line, "range:", 6) == 0) {
+        r->kind = QUERY_INVALID;
+        const char *dash = (const char *)memchr(line + 6, '-', len - 6);
+        if (!dash ||
+            !hex_prefix_to_key(line + 6, (size_t)(dash - line - 6), 0, lo_key) ||
+            !hex_prefix_to_key(dash + 1, (size_t)(line + len - dash - 1), 1, hi_key)) return 1;
+        r->kind = QUERY_RANGE;
+    } else {
+        return 0;
+    }
+
+    r->lo = hash160_interp_lower_bound(db->records, db->count, lo_key);
+    r->hi = r->lo;
+    if (memcmp(lo_key, hi_key, HASH160_SIZE) <= 0) {
+        // 上界包含 hi_key：查找第一個大於 hi_key 的位置
+        r->hi = r->lo + hash160_lower_bound(db->records + r->lo * HASH160_SIZE, db->count - r->lo, hi_key);
+        if (r->hi < db->count && memcmp(db->records + r->hi * HASH160_SIZE, hi_key, HASH160_SIZE) == 0) {
+            r->hi++;
+        }
+    }
+    memcpy(r->key, lo_key, HASH160_SIZE);
+    return 1;
+}
+
+static void query_process_chunk(StreamChunk *chunk, void *ctx)
+{
+    const QueryContext *qc = (const QueryContext *)ctx;
+    const HashDb *db = qc->db;
+    QueryResult *results = (QueryResult *)chunk->results;
+    DecodedLine decoded[256];
+
+    for (size_t base = 0; base < chunk->count; base += 256) {
+        size_t n = chunk->count - base < 256 ? chunk->count - base : 256;
+        decode_lines(chunk->lines + base, n, &default_input_format, decoded);
+        for (size_t j = 0; j < n; j++) {
+            const LineView *lv = &chunk->lines[base + j];
+            QueryResult *r = &results[base + j];
+            const char *buf;
+            size_t len = line_column(lv, 0, &buf);
+            if (len > 0 && parse_query_range(buf, len, db, r)) {
                 continue;
             }
-            strncpy(address_part_buffer, full_line, addr_len);
-            address_part_buffer[addr_len] = '\0';
-        } else {
-            strncpy(address_part_buffer, full_line, sizeof(address_part_buffer) - 1);
-            address_part_buffer[sizeof(address_part_buffer) - 1] = '\0';
+            if (decoded[j].status != SUCCESS_STANDARD_HASH) {
+                r->kind = QUERY_INVALID;
+                continue;
+            }
+            r->kind = QUERY_EXACT;
+            memcpy(r->key, decoded[j].bytes, HASH160_SIZE);
+            r->lo = hash160_interp_lower_bound(db->records, db->count, r->key);
+            r->hi = r->lo < db->count && memcmp(db->records + r->lo * HASH160_SIZE, r->key, HASH160_SIZE) == 0
+                  ? r->lo + 1 : r->lo;
+        }
+    }
+}
+
+/*
+ * 每行輸出一條結果，各列以製表符分隔，最後一列為原始輸入行：
+ *   hit     <hash160> <line>     精確查詢命中
+ *   miss    <hash160> <line>     精確查詢未命中
+ *   count   <n>       <line>     前綴/範圍查詢命中的記錄數，--list 時其後每條記錄一行 "\t<hash160>"
+ *   invalid -         <line>     無法解碼或語法錯誤
+ */
+static int query_emit_chunk(StreamChunk *chunk, void *ctx)
+{
+    QueryContext *qc = (QueryContext *)ctx;
+    const QueryResult *results = (const QueryResult *)chunk->results;
+    char hex[2 * HASH160_SIZE + 1];
+
+    for (size_t i = 0; i < chunk->count; i++) {
+        const QueryResult *r = &results[i];
+        qc->queries++;
+        switch (r->kind) {
+        case QUERY_EXACT:
+            bytes_to_hex(r->key, HASH160_SIZE, hex);
+            fprintf(qc->out, "%s\t%s\t", r->hi > r->lo ? "hit" : "miss", hex);
+            if (r->hi > r->lo) qc->hits++;
+            break;
+        case QUERY_PREFIX:
+        case QUERY_RANGE:
+            fprintf(qc->out, "count\t%zu\t", r->hi - r->lo);
+            if (r->hi > r->lo) qc->hits++;
+            break;
+        default:
+            fputs("invalid\t-\t", qc->out);
+            qc->invalid++;
+            break;
+        }
+        fwrite(chunk->lines[i].ptr, 1, chunk->lines[i].len, qc->out);
+        fputc('\n', qc->out);
+
+        if (qc->list && (r->kind == QUERY_PREFIX || r->kind == QUERY_RANGE)) {
+            for (size_t k = r->lo; k < r->hi; k++) {
+                bytes_to_hex(qc->db->records + k * HASH160_SIZE, HASH160_SIZE, hex);
+                fprintf(qc->out, "\t%s\n", hex);
+            }
         }
-        trim_whitespace(address_part_buffer);
+    }
+    return ferror(qc->out) ? -1 : 0;
+}
+
+static void print_query_usage(const char *prog) {
+    fprintf(stderr, "Usage  : %s query [options] <database> < queries.txt\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "         --list               List the matching hash160 values of prefix/range queries\n");
+    fprintf(stderr, "         --chunk-size <size>  Chunk size, K/M/G suffix allowed (default: 4M)\n");
+    fprintf(stderr, "         -t <n>               Worker threads (default: all available CPUs)\n");
+    fprintf(stderr, "         --affinity           Pin each worker thread to its own CPU\n");
+    fprintf(stderr, "         --reserve-cores <n>  Leave the n highest-numbered CPUs free for other services\n");
+    fprintf(stderr, " <database> is a <prefix>_success.h160 or <prefix>_success.txt written by decode.\n");
+    fprintf(stderr, " Each input line is an address, a 40-digit hash160, prefix:<hex> or range:<hex>-<hex>.\n");
+    fprintf(stderr, "Example: \n");
+    fprintf(stderr, "         ./decode query output_success.h160 < candidates.txt > result.txt\n");
+    fprintf(stderr, "         echo prefix:60efd2 | ./decode query --list output_success.h160\n");
+}
+
+static int run_query_mode(int argc, char *argv[], const char *prog)
+{
+    const char *db_path = NULL;
+    size_t chunk_size = 4u << 20;
+    ThreadOptions thread_opt = {0, 0, false};
+    QueryContext qc;
+    memset(&qc, 0, sizeof(qc));
 
-        if (address_part_buffer[0] == '\0') {
-            data->results[i].status = DECODE_FAILED;
+    for (int i = 0; i < argc; i++) {
+        int t = parse_thread_option(argc, argv, &i, &thread_opt);
+        if (t < 0) {
+            return 1;
+        } else if (t > 0) {
             continue;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            qc.list = true;
+        } else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) {
+            if (!parse_size(argv[++i], &chunk_size) || chunk_size < 4096) {
+                fprintf(stderr, "無效的塊大小: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!db_path && argv[i][0] != '-') {
+            db_path = argv[i];
+        } else {
+            db_path = NULL;
+            break;
         }
+    }
+    if (!db_path) {
+        print_query_usage(prog);
+        return 1;
+    }
+    int thread_count = resolve_thread_count(&thread_opt);
+    if (thread_count == 0) {
+        return 1;
+    }
 
-        unsigned char extracted_bytes[64];
-        size_t extracted_len = 0;
+    HashDb db;
+    if (hash_db_open(db_path, &db) != 0) {
+        return 1;
+    }
+    qc.db = &db;
+    qc.out = stdout;
 
-        if (decode_address_general(address_part_buffer, extracted_bytes, &extracted_len)) {
-            if (extracted_len == 20) {
-                data->results[i].status = SUCCESS_STANDARD_HASH;
-                bytes_to_hex(extracted_bytes, 20, data->results[i].output_hex_str);
-            } else {
-                data->results[i].status = SUCCESS_NON_STANDARD_HASH;
+    StreamConfig cfg;
+    cfg.chunk_size = chunk_size;
+    cfg.max_chunks = thread_count * 2 + 2;
+    cfg.worker_count = thread_count;
+    cfg.result_size = sizeof(QueryResult);
+    cfg.process = query_process_chunk;
+    cfg.emit = query_emit_chunk;
+    cfg.worker_init = stream_worker_init;
+    cfg.ctx = &qc;
+
+    Decompressor dz;
+    if (decompress_open(stdin, NULL, thread_count, chunk_size * (size_t)cfg.max_chunks, &dz) != 0) {
+        perror("無法啟動解壓");
+        hash_db_close(&db);
+        return 1;
+    }
+    cfg.prefix = dz.format == DECOMPRESS_NONE ? dz.prefix : NULL;
+    cfg.prefix_len = dz.format == DECOMPRESS_NONE ? dz.prefix_len : 0;
+    int ret = stream_run(dz.fp, &cfg);
+    fflush(stdout);
+    if (decompress_close(&dz) != 0 && ret == 0) {
+        report_decompress_error();
+        ret = -1;
+    }
+    size_t db_count = db.count;
+    hash_db_close(&db);
+    if (ret != 0) {
+        fprintf(stderr, "查詢處理失敗。\n");
+        return 1;
+    }
+    fprintf(stderr, "Queries: %zu, hits: %zu, misses: %zu, invalid: %zu (database: %zu hash160)\n",
+            qc.queries, qc.hits, qc.queries - qc.hits - qc.invalid, qc.invalid, db_count);
+    return 0;
+}
 
-                const size_t max_bytes_for_buffer = (sizeof(data->results[i].output_hex_str) - 1) / 2;
-                
-                size_t len_to_convert = extracted_len;
+/* -------------------------------------------------------------------------
+ * 9. 集合運算模式：對兩個已排序輸出做並集、交集或差集
+ * -------------------------------------------------------------------------*/
 
-                if (len_to_convert > max_bytes_for_buffer) {
-                    len_to_convert = max_bytes_for_buffer;
-                }
-                
-                bytes_to_hex(extracted_bytes, len_to_convert, data->results[i].output_hex_str);
+static void print_set_usage(const char *prog) {
+    fprintf(stderr, "Usage  : %s set <union|intersect|diff> [options] <A> <B>\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "         -o <prefix>          Output document prefix (default: output)\n");
+    fprintf(stderr, "         --h160               Write <prefix>_success.h160 instead of hex text\n");
+    fprintf(stderr, " <A> and <B> are <prefix>_success.h160 or <prefix>_success.txt files written by decode.\n");
+    fprintf(stderr, " diff writes the hash160 values in <A> that are not in <B>.\n");
+    fprintf(stderr, "Example: \n");
+    fprintf(stderr, "         ./decode set intersect -o common btc_success.h160 ltc_success.h160\n");
+}
 
-            }
+static int run_set_mode(int argc, char *argv[], const char *prog)
+{
+    const char *op = argc > 0 ? argv[0] : "";
+    int out_mask;
+    if (strcmp(op, "union") == 0) {
+        out_mask = (1 << MERGE_ONLY_A) | (1 << MERGE_ONLY_B) | (1 << MERGE_BOTH);
+    } else if (strcmp(op, "intersect") == 0) {
+        out_mask = 1 << MERGE_BOTH;
+    } else if (strcmp(op, "diff") == 0) {
+        out_mask = 1 << MERGE_ONLY_A;
+    } else {
+        print_set_usage(prog);
+        return 1;
+    }
+
+    const char *base_name = "output";
+    bool h160 = false;
+    const char *paths[2] = {NULL, NULL};
+    int npaths = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            base_name = argv[++i];
+        } else if (strcmp(argv[i], "--h160") == 0) {
+            h160 = true;
+        } else if (argv[i][0] != '-' && npaths < 2) {
+            paths[npaths++] = argv[i];
         } else {
-            data->results[i].status = DECODE_FAILED;
+            npaths = 0;
+            break;
         }
     }
-    return NULL;
+    if (npaths != 2) {
+        print_set_usage(prog);
+        return 1;
+    }
+
+    HashDb a, b;
+    if (hash_db_open(paths[0], &a) != 0) return 1;
+    if (hash_db_open(paths[1], &b) != 0) {
+        hash_db_close(&a);
+        return 1;
+    }
+
+    HashWriter out;
+    int ret = hash_writer_open(&out, base_name, "success", h160);
+    if (ret == 0) {
+        HashCursor ca, cb;
+        hash_cursor_init(&ca, &a.records, &a.count, 1);
+        hash_cursor_init(&cb, &b.records, &b.count, 1);
+        size_t stats[3];
+        merge_hash_sets(&ca, &cb, &out, out_mask, NULL, NULL, stats);
+        ret = hash_writer_close(&out);
+        if (ret == 0) {
+            printf("A: %zu, B: %zu, %s: %llu\n", a.count, b.count, op, (unsigned long long)out.count);
+        }
+    }
+    hash_db_close(&a);
+    hash_db_close(&b);
+    return ret == 0 ? 0 : 1;
+}
+
+/*
+ * 讀入整個未壓縮的輸入。path 為 fp 對應的文件路徑（標準輸入傳 NULL）；普通文件直接映射，
+ * 其他輸入整塊讀入，並補上 dz 檢測格式時從不可回退的輸入讀走的字節。
+ * 壓縮的輸入不經過這裡，由流式流水線邊解壓邊解碼。返回 0 表示成功，-1 表示失敗（已輸出錯誤信息）。
+ */
+static int load_input(FILE *fp, const char *path, const Decompressor *dz, InputBuffer *in)
+{
+    if (path && dz->prefix_len == 0) {
+        if (input_load_file(path, in) != 0) {
+            perror("無法打開輸入文件");
+            return -1;
+        }
+        return 0;
+    }
+    if (input_load_stream(fp, dz->prefix, dz->prefix_len, in) != 0) {
+        perror(path ? "無法讀取輸入文件" : "無法讀取標準輸入");
+        return -1;
+    }
+    return 0;
 }
 
-// 比較函數，用於 qsort 排序十六進制字符串 
-int compare_hex_strings(const void *a, const void *b) {
-    const ProcessedResult *res_a = (const ProcessedResult *)a;
-    const ProcessedResult *res_b = (const ProcessedResult *)b;
-    return strcmp(res_a->output_hex_str, res_b->output_hex_str);
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage  : %s [options] <file or address>\n", prog);
+    fprintf(stderr, "  Or   : %s -o <Output document prefix> <file or address>\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "         -o <prefix>          Output document prefix (default: output)\n");
+    fprintf(stderr, "         -t <n>               Worker threads (default: all available CPUs)\n");
+    fprintf(stderr, "         --affinity           Pin each worker thread to its own CPU; buffers are allocated NUMA-local\n");
+    fprintf(stderr, "         --reserve-cores <n>  Leave the n highest-numbered CPUs free for other services\n");
+    fprintf(stderr, "         --work-chunk <lines> Lines per dynamically scheduled work chunk (default: %d)\n", WORK_CHUNK_LINES);
+    fprintf(stderr, "         --stream             Bounded-memory streaming mode for inputs larger than RAM\n");
+    fprintf(stderr, "         --chunk-size <size>  Streaming chunk size, K/M/G suffix allowed (default: 4M)\n");
+    fprintf(stderr, "         --max-chunks <n>     Streaming chunks in flight (default: 2 * threads + 2)\n");
+    fprintf(stderr, "         --h160               Write <prefix>_success.h160 (sorted binary, mmap-able) instead of hex text\n");
+    fprintf(stderr, "         --bloom <fpr>        Also write <prefix>_success.bloom, a blocked Bloom filter with this false-positive rate\n");
+    fprintf(stderr, "         --base <file>        Merge with a previous sorted output; the success file becomes the union\n");
+    fprintf(stderr, "         --delta              With --base, also write <prefix>_added and <prefix>_removed\n");
+    fprintf(stderr, "         --column <n>         Tab-separated column holding the address (default: 1)\n");
+    fprintf(stderr, "         --balance-column <n> Tab-separated column holding the balance in satoshi (default: 2)\n");
+    fprintf(stderr, "         --skip-header        Ignore the first input line\n");
+    fprintf(stderr, "         --min-balance <n>    Skip lines whose balance is below n\n");
+    fprintf(stderr, "         --top <n>            Keep only the n decoded hash160 lines with the highest balance\n");
+    fprintf(stderr, "Example: \n");
+    fprintf(stderr, "         ./decode Input_file_containing_addresses.txt\n");
+    fprintf(stderr, "         ./decode 19qZAgZM4dniNqwuYmQca7FBReTLGX9xyS\n");
+    fprintf(stderr, "         ./decode -o <Output_document_prefix> <Input_file_containing_addresses.txt>\n");
+    fprintf(stderr, "         ./decode -o <Output_document_prefix> <19qZAgZM4dniNqwuYmQca7FBReTLGX9xyS>\n");
+    fprintf(stderr, "         ./decode --stream -o <Output_document_prefix> dump.tsv.gz\n");
+    fprintf(stderr, "         ./decode --base yesterday_success.h160 --delta --h160 -o today today.tsv\n");
+    fprintf(stderr, "         ./decode --skip-header --top 100000 -o rich blockchair_bitcoin_addresses.tsv\n");
+    fprintf(stderr, "         ./decode query <Output_document_prefix>_success.h160 < candidates.txt\n");
+    fprintf(stderr, "         ./decode set <union|intersect|diff> -o <Output_document_prefix> <A> <B>\n");
+    fprintf(stderr, " Tip   : <file or address> is \"-\" means reading from standard input.\n");
+    fprintf(stderr, "         gzip and zstd input is detected and decompressed automatically, and always\n");
+    fprintf(stderr, "         goes through the --stream pipeline so decompression overlaps decoding.\n");
 }
 
+
 int main(int argc, char *argv[]) {
 
     char *input_source = NULL;
-    char *output_base_name = "output";
+    OutputOptions output;
+    memset(&output, 0, sizeof(output));
+    output.base_name = "output";
     bool use_default_output_name = true;
 
-    int thread_count = 4;
-#ifdef _WIN32
-    SYSTEM_INFO sysinfo;
-    GetSystemInfo(&sysinfo);
-    thread_count = sysinfo.dwNumberOfProcessors;
-#else
-    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
-    if (num_cpus > 0) {
-        thread_count = (int)num_cpus;
+    if (argc > 1 && strcmp(argv[1], "query") == 0) {
+        return run_query_mode(argc - 2, argv + 2, argv[0]);
     }
-#endif
-    if (thread_count == 0) thread_count = 1;
-
-    if (argc == 2) {
-        input_source = argv[1];
-    } else if (argc == 4 && strcmp(argv[1], "-o") == 0) {
-        output_base_name = argv[2];
-        input_source = argv[3];
-        use_default_output_name = false;
-    } else {
-        fprintf(stderr, "Usage  : %s <file or address>\n", argv[0]);
-        fprintf(stderr, "  Or   : %s -o <Output document prefix> <file or address>\n", argv[0]);
-        fprintf(stderr, "Example: \n");
-        fprintf(stderr, "         ./decode Input_file_containing_addresses.txt\n");
-        fprintf(stderr, "         ./decode 19qZAgZM4dniNqwuYmQca7FBReTLGX9xyS\n");
-        fprintf(stderr, "         ./decode -o <Output_document_prefix> <Input_file_containing_addresses.txt>\n");
-        fprintf(stderr, "         ./decode -o <Output_document_prefix> <19qZAgZM4dniNqwuYmQca7FBReTLGX9xyS>\n");
-        fprintf(stderr, " Tip   : <file or address> is \"-\" means reading from standard input.\n");
-        return 1;
+    if (argc > 1 && strcmp(argv[1], "set") == 0) {
+        return run_set_mode(argc - 2, argv + 2, argv[0]);
     }
 
-    char outFileSuccessPath[256];
-    char outFileFailurePath[256];
-
-    char **lines = NULL;
-    size_t count = 0;
-    bool is_file_input = false;
+    bool stream_mode = false;
+    size_t work_chunk_lines = WORK_CHUNK_LINES;
+    size_t chunk_size = 4u << 20;
+    int max_chunks = 0;
+    ThreadOptions thread_opt = {0, 0, false};
+    InputFormat input_format = default_input_format;
 
-    FILE *fin = NULL;
-    if (strcmp(input_source, "-") == 0) {
-        fin = stdin;
-        is_file_input = true;
-    } else {
-        fin = fopen(input_source, "r");
-        if (fin) {
-            is_file_input = true;
-        } else {
-            is_file_input = false;
-            if (errno != ENOENT) {
-                perror("無法打開輸入文件");
+    for (int i = 1; i < argc; i++) {
+        int t = parse_thread_option(argc, argv, &i, &thread_opt);
+        if (t < 0) {
+            return 1;
+        } else if (t > 0) {
+            continue;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output.base_name = argv[++i];
+            use_default_output_name = false;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream_mode = true;
+        } else if (strcmp(argv[i], "--h160") == 0) {
+            output.h160 = true;
+        } else if (strcmp(argv[i], "--bloom") == 0 && i + 1 < argc) {
+            char *end;
+            output.bloom_fpr = strtod(argv[++i], &end);
+            if (*end != '\0' || !(output.bloom_fpr > 0.0 && output.bloom_fpr < 1.0)) {
+                fprintf(stderr, "無效的誤判率: %s（應在 0 與 1 之間）\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--base") == 0 && i + 1 < argc) {
+            output.base_path = argv[++i];
+        } else if (strcmp(argv[i], "--delta") == 0) {
+            output.delta = true;
+        } else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) {
+            if (!parse_size(argv[++i], &chunk_size) || chunk_size < 4096) {
+                fprintf(stderr, "無效的塊大小: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--work-chunk") == 0 && i + 1 < argc) {
+            unsigned long long v;
+            if (!parse_count(argv[++i], 1, (size_t)1 << 30, &v)) {
+                fprintf(stderr, "無效的調度塊行數: %s\n", argv[i]);
+                return 1;
+            }
+            // 向上取整到 64 行
+            work_chunk_lines = ((size_t)v + 63) & ~(size_t)63;
+        } else if ((strcmp(argv[i], "--column") == 0 || strcmp(argv[i], "--balance-column") == 0) && i + 1 < argc) {
+            bool is_address = strcmp(argv[i], "--column") == 0;
+            unsigned long long v;
+            if (!parse_count(argv[++i], 1, 1024, &v)) {
+                fprintf(stderr, "無效的列號: %s\n", argv[i]);
+                return 1;
+            }
+            if (is_address) {
+                input_format.address_column = (int)v - 1;
+            } else {
+                input_format.balance_column = (int)v - 1;
+            }
+        } else if (strcmp(argv[i], "--skip-header") == 0) {
+            input_format.skip_header = true;
+        } else if (strcmp(argv[i], "--min-balance") == 0 && i + 1 < argc) {
+            i++;
+            if (!parse_balance(argv[i], strlen(argv[i]), &input_format.min_balance)) {
+                fprintf(stderr, "無效的餘額: %s\n", argv[i]);
+                return 1;
+            }
+            input_format.min_balance_set = true;
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            unsigned long long v;
+            if (!parse_count(argv[++i], 1, SIZE_MAX / 2, &v)) {
+                fprintf(stderr, "無效的數量: %s\n", argv[i]);
+                return 1;
+            }
+            input_format.top_n = (size_t)v;
+        } else if (strcmp(argv[i], "--max-chunks") == 0 && i + 1 < argc) {
+            unsigned long long v;
+            if (!parse_count(argv[++i], 2, 65536, &v)) {
+                fprintf(stderr, "無效的在途塊數: %s（至少為 2）\n", argv[i]);
                 return 1;
             }
+            max_chunks = (int)v;
+        } else if (!input_source && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) {
+            input_source = argv[i];
+        } else {
+            input_source = NULL;
+            break;
         }
     }
-    
-    bool is_single_address_console_output_mode = !is_file_input && use_default_output_name;
 
-    if (is_file_input) {
-        size_t capacity = 1024;
-        lines = (char**)malloc(capacity * sizeof(char*));
-        if(!lines){
-           if (fin != stdin) fclose(fin);
-           perror("內存分配失敗");
-           return 1;
-        }
-
-        char buffer[1024];
-        while(fgets(buffer, sizeof(buffer), fin)){
-           if(count >= capacity){
-             capacity *=2;
-             char** temp = (char**)realloc(lines, capacity * sizeof(char*));
-              if(!temp){
-                 for(size_t i = 0; i < count; i++) free(lines[i]);
-                 free(lines);
-                 if (fin != stdin) fclose(fin);
-                 perror("內存分配失敗");
-                 return 1;
-              }
-              lines = temp;
-            }
-            lines[count] = strdup(buffer);
-             if(!lines[count]){
-                for(size_t i = 0; i < count; i++) free(lines[i]);
-                 free(lines);
-                 if (fin != stdin) fclose(fin);
-                 perror("內存分配失敗");
-                 return 1;
-             }
-            count++;
+    if (!input_source) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (output.delta && !output.base_path) {
+        fprintf(stderr, "--delta 需要與 --base 一起使用。\n");
+        return 1;
+    }
+    int thread_count = resolve_thread_count(&thread_opt);
+    if (thread_count == 0) {
+        return 1;
+    }
+
+    if (max_chunks == 0) {
+        max_chunks = thread_count * 2 + 2;
+    }
+
+    char outFileFailurePath[256];
+
+    InputBuffer input;
+    bool is_file_input = false;
+
+    // 參數不是已存在的文件時把它當作單個地址
+    FILE *fin = strcmp(input_source, "-") == 0 ? stdin : fopen(input_source, "rb");
+    if (fin) {
+        const char *path = fin == stdin ? NULL : input_source;
+        Decompressor dz;
+        if (decompress_open(fin, path, thread_count, chunk_size * (size_t)max_chunks, &dz) != 0) {
+            perror("無法啟動解壓");
+            if (fin != stdin) fclose(fin);
+            return 1;
         }
+        // 壓縮的輸入不必整體讀入，總是走流式流水線：解壓、讀取與解碼同時進行
+        if (stream_mode || dz.format != DECOMPRESS_NONE) {
+            int ret = run_stream_mode(&dz, &output, &input_format, thread_count, chunk_size, max_chunks);
+            if (fin != stdin) fclose(fin);
+            return ret;
+        }
+        int load_ret = load_input(fin, path, &dz, &input);
         if (fin != stdin) fclose(fin);
-         if(count == 0){
-            fprintf(stderr, "輸入文件/標準輸入為空或無有效行。\n");
-            free(lines);
+        if (load_ret != 0) {
             return 1;
-         }
+        }
+        is_file_input = true;
     } else {
-        lines = (char**)malloc(sizeof(char *));
-        if (!lines) {
-            perror("內存分配失敗");
+        if (errno != ENOENT) {
+            perror("無法打開輸入文件");
             return 1;
         }
-        lines[0] = strdup(input_source);
-        if (!lines[0]) {
-            free(lines);
+        if (input_load_string(input_source, &input) != 0) {
             perror("內存分配失敗");
             return 1;
         }
-        count = 1;
     }
 
-    ProcessedResult *all_results = (ProcessedResult*)calloc(count, sizeof(ProcessedResult));
-    if (!all_results) {
+    bool is_single_address_console_output_mode = !is_file_input && use_default_output_name;
+
+    const LineView *lines = input.lines;
+    size_t count = input.count;
+    if (is_file_input && input_format.skip_header && count > 0) {
+        lines++;
+        count--;
+    }
+    if (count == 0) {
+        fprintf(stderr, "輸入文件/標準輸入為空或無有效行。\n");
+        input_free(&input);
+        return 1;
+    }
+
+    // 每行 1 字節狀態；標準哈希由各線程收集在自己的數組中
+    signed char *line_status = (signed char*)malloc(count);
+    if (!line_status) {
         fprintf(stderr, "內存分配失敗。\n");
-        for (size_t i = 0; i < count; i++) free(lines[i]);
-        free(lines);
+        input_free(&input);
         return 1;
     }
 
     pthread_t *threads = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
-    ThreadData *thread_data = (ThreadData*)malloc(thread_count * sizeof(ThreadData));
+    int exit_code = 0;
+    ThreadData *thread_data = (ThreadData*)calloc(thread_count, sizeof(ThreadData));
+    SortShared shared;
+    memset(&shared, 0, sizeof(shared));
+    shared.workers = thread_data;
+    shared.thread_count = thread_count;
+    shared.lines = lines;
+    shared.line_count = count;
+    shared.fmt = &input_format;
+    shared.status = line_status;
+    shared.chunk_lines = work_chunk_lines;
+    shared.chunk_count = (count + work_chunk_lines - 1) / work_chunk_lines;
+    shared.chunks = (WorkChunk*)calloc(shared.chunk_count, sizeof(WorkChunk));
+    if (thread_count > 1) {
+        shared.splitters = (unsigned char*)malloc((thread_count - 1) * HASH160_SIZE);
+    }
 
-    if(!threads || !thread_data){
+    if(!threads || !thread_data || !shared.chunks || (thread_count > 1 && !shared.splitters) ||
+       worker_barrier_init(&shared.barrier, thread_count) != 0){
       fprintf(stderr,"內存分配失敗。\n");
-      for(size_t i = 0; i < count; i++) free(lines[i]);
-      free(lines);
-      free(all_results);
+      input_free(&input);
+      free(line_status);
       free(threads);
       free(thread_data);
+      free(shared.chunks);
+      free(shared.splitters);
       return 1;
     }
 
-    size_t lines_per_thread = count / thread_count;
-    size_t remaining = count % thread_count;
-
     for(int i = 0; i < thread_count; i++){
-       thread_data[i].lines = lines;
-       thread_data[i].start = i * lines_per_thread;
-       thread_data[i].end = (i+1) * lines_per_thread;
-       if(i == thread_count - 1){
-         thread_data[i].end += remaining;
-       }
-       thread_data[i].results = all_results;
+       thread_data[i].id = i;
+       thread_data[i].shared = &shared;
 
       if(pthread_create(&threads[i],NULL,thread_process,&thread_data[i])!=0){
           fprintf(stderr,"無法創建線程%d。\n",i);
+          // 已啟動的線程在屏障處按實際人數放行，並因失敗標記提前退出
+          sort_shared_fail(&shared);
+          worker_barrier_shrink(&shared.barrier, i);
           for(int j = 0; j < i; j++) pthread_join(threads[j],NULL);
-          for(size_t k = 0; k < count; k++) {
-              free(lines[k]);
-          }
-          free(lines); free(all_results); free(threads); free(thread_data);
-          return 1;
+          thread_count = i;
+          exit_code = 1;
+          goto cleanup;
        }
     }
 
@@ -378,106 +2195,104 @@ int main(int argc, char *argv[]) {
       pthread_join(threads[i],NULL);
     }
 
+    if (shared.failed) {
+        fprintf(stderr, "內存分配失敗 (結果收集)。\n");
+        exit_code = 1;
+        goto cleanup;
+    }
+
+    // 各線程已統計好自己的行數，歸併結果按線程順序拼接即為排序去重後的全局結果
     size_t standard_hash_count = 0;
     size_t non_standard_or_failed_count = 0;
-    
-    ProcessedResult *standard_hashes_collection = NULL;
-
-    for (size_t i = 0; i < count; ++i) {
-        if (all_results[i].status == SUCCESS_STANDARD_HASH) {
-            standard_hash_count++;
-        } else {
-            non_standard_or_failed_count++;
-        }
+    for (int t = 0; t < thread_count; t++) {
+        standard_hash_count += thread_data[t].run_count;
+        non_standard_or_failed_count += thread_data[t].failed_count;
     }
 
-    if (standard_hash_count > 0) {
-        standard_hashes_collection = (ProcessedResult*)malloc(standard_hash_count * sizeof(ProcessedResult));
-        if (!standard_hashes_collection) {
-            fprintf(stderr, "內存分配失敗 (結果收集)。\n");
+    if (is_single_address_console_output_mode) {
+        for (int t = 0; t < thread_count; t++) {
+            if (thread_data[t].merged_count > 0) {
+                char hex[2 * HASH160_SIZE + 1];
+                bytes_to_hex(thread_data[t].merged, HASH160_SIZE, hex);
+                fprintf(stdout, "%s\n", hex);
+                break;
+            }
+        }
+    } else {
+        const unsigned char **segs = (const unsigned char **)malloc(thread_count * sizeof(*segs));
+        size_t *seg_counts = (size_t *)malloc(thread_count * sizeof(*seg_counts));
+        if (!segs || !seg_counts) {
+            fprintf(stderr, "內存分配失敗。\n");
+            free(segs); free(seg_counts);
+            exit_code = 1;
             goto cleanup;
         }
-        size_t current_collection_idx = 0;
-        for(size_t i = 0; i < count; ++i) {
-            if (all_results[i].status == SUCCESS_STANDARD_HASH) {
-
-                standard_hashes_collection[current_collection_idx] = all_results[i];
-                current_collection_idx++;
-            }
+        for (int t = 0; t < thread_count; t++) {
+            segs[t] = thread_data[t].merged;
+            seg_counts[t] = thread_data[t].merged_count;
         }
-    }
-
-    if (standard_hash_count > 1) {
-        qsort(standard_hashes_collection, standard_hash_count, sizeof(ProcessedResult), compare_hex_strings);
-    }
-
-    if (is_single_address_console_output_mode) {
-        if (standard_hash_count > 0) {
-            fprintf(stdout, "%s\n", standard_hashes_collection[0].output_hex_str);
+        int wret = write_outputs(&output, segs, seg_counts, thread_count, thread_count);
+        free(segs);
+        free(seg_counts);
+        if (wret != 0) {
+            exit_code = 1;
+            goto cleanup;
         }
-    } else {
-        snprintf(outFileSuccessPath, sizeof(outFileSuccessPath), "%s_success.txt", output_base_name);
-        snprintf(outFileFailurePath, sizeof(outFileFailurePath), "%s_failure.txt", output_base_name);
 
-        FILE *fout_success = fopen(outFileSuccessPath, "w");
+        snprintf(outFileFailurePath, sizeof(outFileFailurePath), "%s_failure.txt", output.base_name);
         FILE *fout_failure = fopen(outFileFailurePath, "w");
-
-        if (!fout_success) {
-            perror("無法打開成功輸出文件");
-            if (fout_failure) fclose(fout_failure);
-            goto cleanup;
-        }
         if (!fout_failure) {
             perror("無法打開失敗輸出文件");
-            if (fout_success) fclose(fout_success);
+            exit_code = 1;
             goto cleanup;
         }
 
-        if (standard_hash_count > 0) {
-            fprintf(fout_success, "%s\n", standard_hashes_collection[0].output_hex_str);
-            for (size_t i = 1; i < standard_hash_count; ++i) {
-                if (strcmp(standard_hashes_collection[i].output_hex_str, standard_hashes_collection[i-1].output_hex_str) != 0) {
-                    fprintf(fout_success, "%s\n", standard_hashes_collection[i].output_hex_str);
-                }
-            }
-        }
-
+        // 每個調度塊的非標準哈希在處理它的線程旁表中連續存放，按塊順序遍歷即為輸入順序
+        const NonStandardEntry *nonstd = NULL;
+        char hex[2 * NON_STANDARD_MAX + 1];
         for (size_t i = 0; i < count; i++) {
-
-            size_t original_index = all_results[i].original_line_index;
-            char* original_line = lines[original_index];
-
-            if (all_results[i].status == DECODE_FAILED) {
-                fprintf(fout_failure, "[DECODE_FAILED] %s", original_line);
-            } else if (all_results[i].status == SUCCESS_NON_STANDARD_HASH) {
-                fprintf(fout_failure, "[NON_STANDARD_HASH: %s] %s", all_results[i].output_hex_str, original_line);
+            if (i % work_chunk_lines == 0) {
+                const WorkChunk *wc = &shared.chunks[i / work_chunk_lines];
+                nonstd = thread_data[wc->worker].nonstd + wc->nonstd_start;
             }
-
-            if (all_results[i].status != SUCCESS_STANDARD_HASH &&
-                strlen(original_line) > 0 &&
-                original_line[strlen(original_line)-1] != '\n') {
-                fprintf(fout_failure, "\n");
+            if (line_status[i] == SUCCESS_STANDARD_HASH || line_status[i] == LINE_FILTERED) {
+                continue;
+            }
+            if (line_status[i] == DECODE_FAILED) {
+                fprintf(fout_failure, "[DECODE_FAILED] ");
+            } else {
+                const NonStandardEntry *e = nonstd++;
+                bytes_to_hex(e->bytes, e->len, hex);
+                fprintf(fout_failure, "[NON_STANDARD_HASH: %s] ", hex);
             }
+            fwrite(lines[i].ptr, 1, lines[i].len, fout_failure);
+            fputc('\n', fout_failure);
         }
 
-        fclose(fout_success);
         fclose(fout_failure);
 
         printf("Total  quantity: %zu\n", count);
         printf("Hash160 Success: %zu (Deduplicated and sorted)\n", standard_hash_count);
         printf("Hash160  failed: %zu\n", non_standard_or_failed_count);
+        if (input_format.min_balance_set || input_format.top_n > 0) {
+            printf("Filtered  lines: %zu\n", count - standard_hash_count - non_standard_or_failed_count);
+        }
     }
 
 cleanup:
-    for (size_t i = 0; i < count; i++) {
-        free(lines[i]);
-
+    input_free(&input);
+    free(line_status);
+    for (int t = 0; t < thread_count; t++) {
+        free(thread_data[t].run);
+        free(thread_data[t].nonstd);
+        free(thread_data[t].merged);
+        free(thread_data[t].top);
     }
-    free(lines);
-    free(all_results);
-    free(standard_hashes_collection);
+    worker_barrier_destroy(&shared.barrier);
+    free(shared.chunks);
+    free(shared.splitters);
     free(threads);
     free(thread_data);
 
-    return 0;
+    return exit_code;
 }
@@ -0,0 +1,310 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "polymod.h"
+#include <string.h>
+
+// Bech32 生成元表：下標為校驗值移出的高 5 位，值為各位對應生成元的異或
+static const uint32_t BECH32_GEN_TABLE[32] = {
+    0x00000000, 0x3b6a57b2, 0x26508e6d, 0x1d3ad9df,
+    0x1ea119fa, 0x25cb4e48, 0x38f19797, 0x039bc025,
+    0x3d4233dd, 0x0628646f, 0x1b12bdb0, 0x2078ea02,
+    0x23e32a27, 0x18897d95, 0x05b3a44a, 0x3ed9f3f8,
+    0x2a1462b3, 0x117e3501, 0x0c44ecde, 0x372ebb6c,
+    0x34b57b49, 0x0fdf2cfb, 0x12e5f524, 0x298fa296,
+    0x1756516e, 0x2c3c06dc, 0x3106df03, 0x0a6c88b1,
+    0x09f74894, 0x329d1f26, 0x2fa7c6f9, 0x14cd914b
+};
+
+// CashAddr 生成元表，含義同上
+static const uint64_t CASHADDR_GEN_TABLE[32] = {
+    0x0000000000ULL, 0x98f2bc8e61ULL, 0x79b76d99e2ULL, 0xe145d11783ULL,
+    0xf33e5fb3c4ULL, 0x6bcce33da5ULL, 0x8a89322a26ULL, 0x127b8ea447ULL,
+    0xae2eabe2a8ULL, 0x36dc176cc9ULL, 0xd799c67b4aULL, 0x4f6b7af52bULL,
+    0x5d10f4516cULL, 0xc5e248df0dULL, 0x24a799c88eULL, 0xbc552546efULL,
+    0x1e4f43e470ULL, 0x86bdff6a11ULL, 0x67f82e7d92ULL, 0xff0a92f3f3ULL,
+    0xed711c57b4ULL, 0x7583a0d9d5ULL, 0x94c671ce56ULL, 0x0c34cd4037ULL,
+    0xb061e806d8ULL, 0x28935488b9ULL, 0xc9d6859f3aULL, 0x512439115bULL,
+    0x435fb7b51cULL, 0xdbad0b3b7dULL, 0x3ae8da2cfeULL, 0xa21a66a29fULL
+};
+
+uint32_t bech32_polymod(const uint8_t *values, size_t len)
+{
+    uint32_t chk = 1;
+    for (size_t i = 0; i < len; ++i)
+        chk = ((chk & 0x1ffffff) << 5) ^ values[i] ^ BECH32_GEN_TABLE[chk >> 25];
+    return chk;
+}
+
+uint64_t cashaddr_polymod(const uint8_t *values, size_t len)
+{
+    uint64_t c = 1;
+    for (size_t i = 0; i < len; ++i)
+        c = ((c & 0x07ffffffffULL) << 5) ^ values[i] ^ CASHADDR_GEN_TABLE[c >> 35];
+    return c;
+}
+
+/* -------------------------------------------------------------------------
+ * 多通道實現：t 為轉置後的值，t[i * POLYMOD_BATCH_MAX + l] 是第 l 條序列的第 i 個值；
+ * lens[l] 為第 l 條序列的長度，i >= lens[l] 之後該通道保持不變。
+ * -------------------------------------------------------------------------*/
+typedef void (*bech32_batch_fn)(const uint8_t *t, const uint32_t *lens, size_t maxlen, uint32_t *out);
+typedef void (*cashaddr_batch_fn)(const uint8_t *t, const uint32_t *lens, size_t maxlen, uint64_t *out);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POLYMOD_X86_DISPATCH 1
+#include <immintrin.h>
+
+// AVX2 沒有通道內查表，按移出的 5 位逐位選擇生成元
+#define BECH32_GEN_BIT8(top, j, g) \
+    _mm256_and_si256(_mm256_srai_epi32(_mm256_slli_epi32((top), 31 - (j)), 31), (g))
+
+// AVX2：8 條 Bech32 序列並行
+__attribute__((target("avx2")))
+static void bech32_polymod_x8(const uint8_t *t, const uint32_t *lens, size_t maxlen, uint32_t *out)
+{
+    const __m256i low25 = _mm256_set1_epi32(0x1ffffff);
+    const __m256i g0 = _mm256_set1_epi32((int)BECH32_GEN_TABLE[1]);
+    const __m256i g1 = _mm256_set1_epi32((int)BECH32_GEN_TABLE[2]);
+    const __m256i g2 = _mm256_set1_epi32((int)BECH32_GEN_TABLE[4]);
+    const __m256i g3 = _mm256_set1_epi32((int)BECH32_GEN_TABLE[8]);
+    const __m256i g4 = _mm256_set1_epi32((int)BECH32_GEN_TABLE[16]);
+    const __m256i len = _mm256_loadu_si256((const __m256i *)lens);
+    __m256i chk = _mm256_set1_epi32(1);
+
+    for (size_t i = 0; i < maxlen; ++i) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(t + i * POLYMOD_BATCH_MAX)));
+        __m256i top = _mm256_srli_epi32(chk, 25);
+        __m256i next = _mm256_xor_si256(_mm256_slli_epi32(_mm256_and_si256(chk, low25), 5), v);
+        next = _mm256_xor_si256(next, BECH32_GEN_BIT8(top, 0, g0));
+        next = _mm256_xor_si256(next, BECH32_GEN_BIT8(top, 1, g1));
+        next = _mm256_xor_si256(next, BECH32_GEN_BIT8(top, 2, g2));
+        next = _mm256_xor_si256(next, BECH32_GEN_BIT8(top, 3, g3));
+        next = _mm256_xor_si256(next, BECH32_GEN_BIT8(top, 4, g4));
+        __m256i active = _mm256_cmpgt_epi32(len, _mm256_set1_epi32((int)i));
+        chk = _mm256_blendv_epi8(chk, next, active);
+    }
+    _mm256_storeu_si256((__m256i *)out, chk);
+}
+
+#define CASHADDR_GEN_BIT4(top, bit, g) \
+    _mm256_and_si256(_mm256_cmpeq_epi64(_mm256_and_si256((top), (bit)), (bit)), (g))
+
+// AVX2：8 條 CashAddr 序列並行，每個寄存器 4 個 64 位通道
+__attribute__((target("avx2")))
+static void cashaddr_polymod_x8(const uint8_t *t, const uint32_t *lens, size_t maxlen, uint64_t *out)
+{
+    const __m256i low35 = _mm256_set1_epi64x(0x07ffffffffLL);
+    __m256i bit[5], g[5];
+    for (int j = 0; j < 5; ++j) {
+        bit[j] = _mm256_set1_epi64x(1LL << j);
+        g[j] = _mm256_set1_epi64x((long long)CASHADDR_GEN_TABLE[1 << j]);
+    }
+    __m256i len[2], c[2];
+    for (int h = 0; h < 2; ++h) {
+        len[h] = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(lens + 4 * h)));
+        c[h] = _mm256_set1_epi64x(1);
+    }
+
+    for (size_t i = 0; i < maxlen; ++i) {
+        __m128i raw = _mm_loadl_epi64((const __m128i *)(t + i * POLYMOD_BATCH_MAX));
+        __m256i v[2] = { _mm256_cvtepu8_epi64(raw), _mm256_cvtepu8_epi64(_mm_srli_si128(raw, 4)) };
+        __m256i idx = _mm256_set1_epi64x((long long)i);
+        for (int h = 0; h < 2; ++h) {
+            __m256i top = _mm256_srli_epi64(c[h], 35);
+            __m256i next = _mm256_xor_si256(_mm256_slli_epi64(_mm256_and_si256(c[h], low35), 5), v[h]);
+            for (int j = 0; j < 5; ++j)
+                next = _mm256_xor_si256(next, CASHADDR_GEN_BIT4(top, bit[j], g[j]));
+            __m256i active = _mm256_cmpgt_epi64(len[h], idx);
+            c[h] = _mm256_blendv_epi8(c[h], next, active);
+        }
+    }
+    for (int h = 0; h < 2; ++h)
+        _mm256_storeu_si256((__m256i *)(out + 4 * h), c[h]);
+}
+
+// AVX-512：16 條 Bech32 序列並行，32 項生成元表由雙寄存器置換一次查出
+__attribute__((target("avx512f")))
+static void bech32_polymod_x16(const uint8_t *t, const uint32_t *lens, size_t maxlen, uint32_t *out)
+{
+    const __m512i low25 = _mm512_set1_epi32(0x1ffffff);
+    const __m512i tab_lo = _mm512_loadu_si512((const void *)BECH32_GEN_TABLE);
+    const __m512i tab_hi = _mm512_loadu_si512((const void *)(BECH32_GEN_TABLE + 16));
+    const __m512i len = _mm512_loadu_si512((const void *)lens);
+    __m512i chk = _mm512_set1_epi32(1);
+
+    for (size_t i = 0; i < maxlen; ++i) {
+        __m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(t + i * POLYMOD_BATCH_MAX)));
+        __m512i top = _mm512_srli_epi32(chk, 25);
+        __m512i next = _mm512_xor_si512(_mm512_slli_epi32(_mm512_and_si512(chk, low25), 5), v);
+        next = _mm512_xor_si512(next, _mm512_permutex2var_epi32(tab_lo, top, tab_hi));
+        __mmask16 active = _mm512_cmpgt_epu32_mask(len, _mm512_set1_epi32((int)i));
+        chk = _mm512_mask_mov_epi32(chk, active, next);
+    }
+    _mm512_storeu_si512((void *)out, chk);
+}
+
+// AVX-512：16 條 CashAddr 序列並行；低 4 位查 16 項表，第 5 位單獨按掩碼異或
+__attribute__((target("avx512f")))
+static void cashaddr_polymod_x16(const uint8_t *t, const uint32_t *lens, size_t maxlen, uint64_t *out)
+{
+    const __m512i low35 = _mm512_set1_epi64(0x07ffffffffLL);
+    const __m512i tab_lo = _mm512_loadu_si512((const void *)CASHADDR_GEN_TABLE);
+    const __m512i tab_hi = _mm512_loadu_si512((const void *)(CASHADDR_GEN_TABLE + 8));
+    const __m512i bit4 = _mm512_set1_epi64(16);
+    const __m512i g4 = _mm512_set1_epi64((long long)CASHADDR_GEN_TABLE[16]);
+    __m512i len[2], c[2];
+    for (int h = 0; h < 2; ++h) {
+        len[h] = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(lens + 8 * h)));
+        c[h] = _mm512_set1_epi64(1);
+    }
+
+    for (size_t i = 0; i < maxlen; ++i) {
+        __m128i raw = _mm_loadu_si128((const __m128i *)(t + i * POLYMOD_BATCH_MAX));
+        __m512i v[2] = { _mm512_cvtepu8_epi64(raw), _mm512_cvtepu8_epi64(_mm_srli_si128(raw, 8)) };
+        __m512i idx = _mm512_set1_epi64((long long)i);
+        for (int h = 0; h < 2; ++h) {
+            __m512i top = _mm512_srli_epi64(c[h], 35);
+            __m512i next = _mm512_xor_si512(_mm512_slli_epi64(_mm512_and_si512(c[h], low35), 5), v[h]);
+            next = _mm512_xor_si512(next, _mm512_permutex2var_epi64(tab_lo, top, tab_hi));
+            next = _mm512_mask_xor_epi64(next, _mm512_test_epi64_mask(top, bit4), next, g4);
+            c[h] = _mm512_mask_mov_epi64(c[h], _mm512_cmpgt_epu64_mask(len[h], idx), next);
+        }
+    }
+    for (int h = 0; h < 2; ++h)
+        _mm512_storeu_si512((void *)(out + 8 * h), c[h]);
+}
+#endif
+
+static bech32_batch_fn bech32_batch_impl = NULL;
+static cashaddr_batch_fn cashaddr_batch_impl = NULL;
+static size_t polymod_lanes = 1;
+static const char *polymod_impl = "scalar";
+
+int polymod_set_batch_impl(const char *name)
+{
+    if (strcmp(name, "scalar") == 0) {
+        bech32_batch_impl = NULL;
+        cashaddr_batch_impl = NULL;
+        polymod_lanes = 1;
+        polymod_impl = "scalar";
+        return 1;
+    }
+#ifdef POLYMOD_X86_DISPATCH
+    __builtin_cpu_init();
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        bech32_batch_impl = bech32_polymod_x8;
+        cashaddr_batch_impl = cashaddr_polymod_x8;
+        polymod_lanes = 8;
+        polymod_impl = "avx2";
+        return 1;
+    }
+    if (strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f")) {
+        bech32_batch_impl = bech32_polymod_x16;
+        cashaddr_batch_impl = cashaddr_polymod_x16;
+        polymod_lanes = 16;
+        polymod_impl = "avx512";
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+const char *polymod_batch_impl_name(void)
+{
+    return polymod_impl;
+}
+
+// 啟動時選擇最快的可用實現
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void polymod_select_impl(void)
+{
+    if (!polymod_set_batch_impl("avx512") && !polymod_set_batch_impl("avx2"))
+        polymod_set_batch_impl("scalar");
+}
+
+/*
+ * 把一組序列轉置到 t 中；超過 POLYMOD_MAX_VALUES 的序列長度記為 0，由調用者逐條計算。
+ * 返回最長序列的長度。
+ */
+static size_t polymod_transpose(const uint8_t *const values[], const size_t lens[], size_t count,
+                                uint8_t *t, uint32_t lane_lens[POLYMOD_BATCH_MAX])
+{
+    size_t maxlen = 0;
+    memset(lane_lens, 0, POLYMOD_BATCH_MAX * sizeof(uint32_t));
+    for (size_t l = 0; l < count; ++l) {
+        if (lens[l] > POLYMOD_MAX_VALUES)
+            continue;
+        lane_lens[l] = (uint32_t)lens[l];
+        if (lens[l] > maxlen)
+            maxlen = lens[l];
+    }
+    memset(t, 0, maxlen * POLYMOD_BATCH_MAX);
+    for (size_t l = 0; l < count; ++l) {
+        for (size_t i = 0; i < lane_lens[l]; ++i)
+            t[i * POLYMOD_BATCH_MAX + l] = values[l][i];
+    }
+    return maxlen;
+}
+
+void bech32_polymod_batch(const uint8_t *const values[], const size_t lens[], size_t n, uint32_t out[])
+{
+#if !defined(__GNUC__)
+    static int selected = 0;
+    if (!selected) {
+        polymod_select_impl();
+        selected = 1;
+    }
+#endif
+    for (size_t base = 0; base < n; base += POLYMOD_BATCH_MAX) {
+        size_t count = n - base < POLYMOD_BATCH_MAX ? n - base : POLYMOD_BATCH_MAX;
+        if (!bech32_batch_impl) {
+            for (size_t l = 0; l < count; ++l)
+                out[base + l] = bech32_polymod(values[base + l], lens[base + l]);
+            continue;
+        }
+
+        uint8_t t[POLYMOD_MAX_VALUES * POLYMOD_BATCH_MAX];
+        uint32_t lane_lens[POLYMOD_BATCH_MAX];
+        uint32_t res[POLYMOD_BATCH_MAX];
+        size_t maxlen = polymod_transpose(values + base, lens + base, count, t, lane_lens);
+        for (size_t lane0 = 0; lane0 < count; lane0 += polymod_lanes)
+            bech32_batch_impl(t + lane0, lane_lens + lane0, maxlen, res + lane0);
+        for (size_t l = 0; l < count; ++l) {
+            out[base + l] = lens[base + l] > POLYMOD_MAX_VALUES
+                          ? bech32_polymod(values[base + l], lens[base + l]) : res[l];
+        }
+    }
+}
+
+void cashaddr_polymod_batch(const uint8_t *const values[], const size_t lens[], size_t n, uint64_t out[])
+{
+#if !defined(__GNUC__)
+    static int selected = 0;
+    if (!selected) {
+        polymod_select_impl();
+        selected = 1;
+    }
+#endif
+    for (size_t base = 0; base < n; base += POLYMOD_BATCH_MAX) {
+        size_t count = n - base < POLYMOD_BATCH_MAX ? n - base : POLYMOD_BATCH_MAX;
+        if (!cashaddr_batch_impl) {
+            for (size_t l = 0; l < count; ++l)
+                out[base + l] = cashaddr_polymod(values[base + l], lens[base + l]);
+            continue;
+        }
+
+        uint8_t t[POLYMOD_MAX_VALUES * POLYMOD_BATCH_MAX];
+        uint32_t lane_lens[POLYMOD_BATCH_MAX];
+        uint64_t res[POLYMOD_BATCH_MAX];
+        size_t maxlen = polymod_transpose(values + base, lens + base, count, t, lane_lens);
+        for (size_t lane0 = 0; lane0 < count; lane0 += polymod_lanes)
+            cashaddr_batch_impl(t + lane0, lane_lens + lane0, maxlen, res + lane0);
+        for (size_t l = 0; l < count; ++l) {
+            out[base + l] = lens[base + l] > POLYMOD_MAX_VALUES
+                          ? cashaddr_polymod(values[base + l], lens[base + l]) : res[l];
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef POLYMOD_H
+#define POLYMOD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 一次批量計算的最大通道數
+#define POLYMOD_BATCH_MAX 16
+// 批量計算中可按通道並行處理的最長序列，更長的序列逐條計算
+#define POLYMOD_MAX_VALUES 256
+
+// Bech32 校驗和（30 位生成元）：對 5 位值序列計算 polymod，初值為 1，不異或編碼常量
+uint32_t bech32_polymod(const uint8_t *values, size_t len);
+// CashAddr 校驗和（40 位生成元）：對 5 位值序列計算 polymod，初值為 1，不異或常量
+uint64_t cashaddr_polymod(const uint8_t *values, size_t len);
+
+// 批量計算 out[i] = bech32_polymod(values[i], lens[i])。序列按轉置佈局每 16（AVX-512）或 8（AVX2）
+// 條並行計算，長度不同的序列在較短者結束後保持其結果；長度相近時效率最高。
+void bech32_polymod_batch(const uint8_t *const values[], const size_t lens[], size_t n, uint32_t out[]);
+// 批量計算 out[i] = cashaddr_polymod(values[i], lens[i])，並行方式同上（每通道 64 位）
+void cashaddr_polymod_batch(const uint8_t *const values[], const size_t lens[], size_t n, uint64_t out[]);
+
+// 批量實現在程序啟動時自動選擇（AVX-512 > AVX2 > 標量）
+// name: "avx512"、"avx2" 或 "scalar"；CPU 不支持時返回 0 並保持原實現
+int polymod_set_batch_impl(const char *name);
+// 返回當前批量實現的名稱
+const char *polymod_batch_impl_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POLYMOD_H
@@ -0,0 +1,117 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "runfile.h"
+#include "hashsort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+int run_file_open(RunFile *rf, const char *prefix)
+{
+    memset(rf, 0, sizeof(*rf));
+#ifdef _WIN32
+    (void)prefix;
+    rf->fp = tmpfile();
+    return rf->fp ? 0 : -1;
+#else
+    // 放在輸出文件旁邊：結果本來就寫在那裡，空間通常比 /tmp 充裕
+    char path[4096];
+    if (snprintf(path, sizeof(path), "%s_sort.XXXXXX", prefix) >= (int)sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return -1;
+    unlink(path);
+    rf->fp = fdopen(fd, "w+b");
+    if (!rf->fp) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+int run_file_append(RunFile *rf, const uint8_t *keys, size_t n)
+{
+    if (rf->run_count == rf->run_capacity) {
+        size_t capacity = rf->run_capacity ? rf->run_capacity * 2 : 64;
+        size_t *temp = (size_t *)realloc(rf->run_ends, capacity * sizeof(size_t));
+        if (!temp) {
+            errno = ENOMEM;
+            return -1;
+        }
+        rf->run_ends = temp;
+        rf->run_capacity = capacity;
+    }
+    if (n > 0 && fwrite(keys, HASH160_SIZE, n, rf->fp) != n)
+        return -1;
+    rf->key_count += n;
+    rf->run_ends[rf->run_count++] = rf->key_count;
+    return 0;
+}
+
+int run_file_map(RunFile *rf, size_t extra)
+{
+    if (fflush(rf->fp) != 0)
+        return -1;
+    rf->size = (rf->key_count + extra) * HASH160_SIZE;
+    if (rf->size == 0)
+        return 0;
+#ifdef _WIN32
+    rf->base = (uint8_t *)malloc(rf->size);
+    if (!rf->base) {
+        errno = ENOMEM;
+        return -1;
+    }
+    rewind(rf->fp);
+    if (fread(rf->base, HASH160_SIZE, rf->key_count, rf->fp) != rf->key_count) {
+        free(rf->base);
+        rf->base = NULL;
+        errno = EIO;
+        return -1;
+    }
+#else
+    int fd = fileno(rf->fp);
+    if (ftruncate(fd, (off_t)rf->size) != 0)
+        return -1;
+    void *map = mmap(NULL, rf->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return -1;
+    rf->base = (uint8_t *)map;
+    rf->is_mapped = 1;
+#endif
+    return 0;
+}
+
+const uint8_t *run_file_run(const RunFile *rf, size_t i, size_t *len)
+{
+    size_t start = i == 0 ? 0 : rf->run_ends[i - 1];
+    *len = rf->run_ends[i] - start;
+    return rf->base + start * HASH160_SIZE;
+}
+
+void run_file_close(RunFile *rf)
+{
+    if (rf->base) {
+#ifndef _WIN32
+        if (rf->is_mapped)
+            munmap(rf->base, rf->size);
+        else
+#endif
+            free(rf->base);
+    }
+    if (rf->fp)
+        fclose(rf->fp);
+    free(rf->run_ends);
+    memset(rf, 0, sizeof(*rf));
+}
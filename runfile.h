@@ -0,0 +1,52 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef RUNFILE_H
+#define RUNFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 外部排序的臨時文件：依次追加若干段已排序的 hash160，寫完後整個映射，供多路歸併讀取。
+ * 映射時可在各段之後預留 extra 個鍵的可寫空間作為歸併結果，結果同樣落在文件上，
+ * 內存不足時由頁面緩存換出，而不是佔用匿名內存。
+ * 文件創建後立即刪除，關閉或進程退出時由系統回收。
+ */
+typedef struct {
+    FILE *fp;
+    size_t key_count;          // 已寫入的鍵數
+    size_t *run_ends;          // 每段結束處的累計鍵數
+    size_t run_count;
+    size_t run_capacity;
+    uint8_t *base;             // run_file_map 之後：各段依次存放，其後為預留空間
+    size_t size;
+    int is_mapped;             // 1 表示 base 來自 mmap，0 表示整塊讀入
+} RunFile;
+
+// 在 prefix 所在的目錄創建臨時文件（名為 <prefix>_sort.XXXXXX）。返回 0 表示成功，-1 表示失敗（errno 保存原因）。
+int run_file_open(RunFile *rf, const char *prefix);
+
+// 追加一段已排序的 n 個鍵。返回 0 表示成功，-1 表示寫入失敗或內存不足。
+int run_file_append(RunFile *rf, const uint8_t *keys, size_t n);
+
+// 寫完後映射整個文件，並在末尾預留 extra 個鍵的可寫空間（位於 base + key_count × 20）。
+// 返回 0 表示成功，-1 表示失敗（errno 保存原因）。
+int run_file_map(RunFile *rf, size_t extra);
+
+// 映射後第 i 段的起始地址，*len 為其鍵數
+const uint8_t *run_file_run(const RunFile *rf, size_t i, size_t *len);
+
+// 解除映射並關閉（刪除）臨時文件
+void run_file_close(RunFile *rf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RUNFILE_H
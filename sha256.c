@@ -38,54 +38,472 @@ static const uint32_t k[64] = {
     0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
 };
 
-// 處理 512 位數據塊
-static void sha256_transform(SHA256_CTX *ctx, const uint8_t data[])
+// 初始哈希值
+static const uint32_t sha256_h0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/* -------------------------------------------------------------------------
+ * 壓縮函數的各種實現：state 為 8 個 32 位字，data 為 blocks 個連續的 64 字節塊。
+ * 啟動時根據 CPUID 選擇 SHA-NI、AVX2 或可移植的標量實現，sha256_* 接口保持不變。
+ * -------------------------------------------------------------------------*/
+typedef void (*sha256_transform_fn)(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+// 可移植的標量實現
+static void sha256_transform_scalar(uint32_t state[8], const uint8_t *data, size_t blocks)
 {
     uint32_t m[64];
     uint32_t a, b, c, d, e, f, g, h;
     uint32_t t1, t2;
     int i, j;
 
-    // 將輸入數據按大端方式轉換為 32 位整數陣列
-    for (i = 0, j = 0; i < 16; ++i, j += 4)
-        m[i] = (data[j] << 24) | (data[j+1] << 16) | (data[j+2] << 8) | (data[j+3]);
-    for ( ; i < 64; ++i)
-        m[i] = SIG1(m[i-2]) + m[i-7] + SIG0(m[i-15]) + m[i-16];
+    for (; blocks > 0; --blocks, data += 64) {
+        // 將輸入數據按大端方式轉換為 32 位整數陣列
+        for (i = 0, j = 0; i < 16; ++i, j += 4)
+            m[i] = ((uint32_t)data[j] << 24) | (data[j+1] << 16) | (data[j+2] << 8) | (data[j+3]);
+        for ( ; i < 64; ++i)
+            m[i] = SIG1(m[i-2]) + m[i-7] + SIG0(m[i-15]) + m[i-16];
 
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
 
-    for (i = 0; i < 64; ++i) {
-        t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-        t2 = EP0(a) + MAJ(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+        for (i = 0; i < 64; ++i) {
+            t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
+            t2 = EP0(a) + MAJ(a,b,c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
     }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_X86_DISPATCH 1
+#include <cpuid.h>
+#include <immintrin.h>
+
+/*
+ * AVX2 實現：消息擴展用 128 位向量一次計算 4 個字（W[t+2..t+3] 依賴剛算出的 W[t..t+1]，分兩半完成），
+ * 並預先加上常量 K；輪函數保持標量，由編譯器生成 BMI2 的 rorx 無標誌位旋轉。
+ */
+#define VROR(x, n) _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
 
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
+__attribute__((target("avx2,bmi2")))
+static void sha256_transform_avx2(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    uint32_t wk[64] __attribute__((aligned(16)));
+
+    for (; blocks > 0; --blocks, data += 64) {
+        __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data +  0)), bswap);
+        __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+        __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+        __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+        for (int t = 0; t < 64; t += 4) {
+            // x0..x3 保存 W[t..t+15]，先輸出 W[t..t+3] + K[t..t+3]
+            _mm_store_si128((__m128i *)&wk[t], _mm_add_epi32(x0, _mm_loadu_si128((const __m128i *)&k[t])));
+            if (t >= 48) {
+                x0 = x1; x1 = x2; x2 = x3;
+                continue;
+            }
+            // 計算 W[t+16..t+19]
+            __m128i w1 = _mm_alignr_epi8(x1, x0, 4);     // W[t+1..t+4]
+            __m128i w9 = _mm_alignr_epi8(x3, x2, 4);     // W[t+9..t+12]
+            __m128i s0 = _mm_xor_si128(_mm_xor_si128(VROR(w1, 7), VROR(w1, 18)), _mm_srli_epi32(w1, 3));
+            __m128i tmp = _mm_add_epi32(_mm_add_epi32(x0, s0), w9);
+
+            // 低兩個字：σ1(W[t+14]), σ1(W[t+15])
+            __m128i w14 = _mm_shuffle_epi32(x3, 0xFE);    // W[t+14], W[t+15], -, -
+            __m128i s1 = _mm_xor_si128(_mm_xor_si128(VROR(w14, 17), VROR(w14, 19)), _mm_srli_epi32(w14, 10));
+            s1 = _mm_and_si128(s1, _mm_set_epi32(0, 0, -1, -1));
+            tmp = _mm_add_epi32(tmp, s1);
+
+            // 高兩個字：σ1(W[t+16]), σ1(W[t+17])，依賴剛計算出的低兩個字
+            __m128i w16 = _mm_shuffle_epi32(tmp, 0x40);   // -, -, W[t+16], W[t+17]
+            s1 = _mm_xor_si128(_mm_xor_si128(VROR(w16, 17), VROR(w16, 19)), _mm_srli_epi32(w16, 10));
+            s1 = _mm_and_si128(s1, _mm_set_epi32(-1, -1, 0, 0));
+            tmp = _mm_add_epi32(tmp, s1);
+
+            x0 = x1; x1 = x2; x2 = x3; x3 = tmp;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + EP1(e) + CH(e,f,g) + wk[i];
+            uint32_t t2 = EP0(a) + MAJ(a,b,c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+/*
+ * SHA-NI 實現：每 4 輪一組，sha256rnds2 完成兩輪，sha256msg1/msg2 完成消息擴展。
+ * g 為組號（0～15），m_cur 為本組的 W，m_prev/m_next 為前後一組。
+ */
+#define SHANI_QROUND(g, m_cur, m_prev, m_next) do {                               \
+        msg = _mm_add_epi32(m_cur, _mm_loadu_si128((const __m128i *)&k[4 * (g)])); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                       \
+        if ((g) >= 3 && (g) <= 14) {                                               \
+            tmp = _mm_alignr_epi8(m_cur, m_prev, 4);                               \
+            m_next = _mm_add_epi32(m_next, tmp);                                   \
+            m_next = _mm_sha256msg2_epu32(m_next, m_cur);                          \
+        }                                                                          \
+        msg = _mm_shuffle_epi32(msg, 0x0E);                                        \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                       \
+        if ((g) >= 1 && (g) <= 12)                                                 \
+            m_prev = _mm_sha256msg1_epu32(m_prev, m_cur);                          \
+    } while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_transform_shani(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, msg, tmp, m0, m1, m2, m3, abef_save, cdgh_save;
+
+    // 把 state 重排為 sha256rnds2 需要的 ABEF / CDGH 佈局
+    tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+    state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);              // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);        // EFGH
+    state0 = _mm_alignr_epi8(tmp, state1, 8);        // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);     // CDGH
+
+    for (; blocks > 0; --blocks, data += 64) {
+        abef_save = state0;
+        cdgh_save = state1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data +  0)), bswap);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+        SHANI_QROUND( 0, m0, m3, m1);
+        SHANI_QROUND( 1, m1, m0, m2);
+        SHANI_QROUND( 2, m2, m1, m3);
+        SHANI_QROUND( 3, m3, m2, m0);
+        SHANI_QROUND( 4, m0, m3, m1);
+        SHANI_QROUND( 5, m1, m0, m2);
+        SHANI_QROUND( 6, m2, m1, m3);
+        SHANI_QROUND( 7, m3, m2, m0);
+        SHANI_QROUND( 8, m0, m3, m1);
+        SHANI_QROUND( 9, m1, m0, m2);
+        SHANI_QROUND(10, m2, m1, m3);
+        SHANI_QROUND(11, m3, m2, m0);
+        SHANI_QROUND(12, m0, m3, m1);
+        SHANI_QROUND(13, m1, m0, m2);
+        SHANI_QROUND(14, m2, m1, m3);
+        SHANI_QROUND(15, m3, m2, m0);
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    // 還原為 A..H 的順序
+    tmp = _mm_shuffle_epi32(state0, 0x1B);           // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);        // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);     // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);        // HGFE
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+// 檢查 CPU 及操作系統是否支持 AVX2（含 YMM 狀態保存）和 BMI2
+static int cpu_has_avx2(void)
+{
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d))
+        return 0;
+    if (!(c & bit_OSXSAVE) || !(c & bit_AVX))
+        return 0;
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 6) != 6)
+        return 0;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+        return 0;
+    return (b & bit_AVX2) && (b & bit_BMI2);
+}
+
+static int cpu_has_shani(void)
+{
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d))
+        return 0;
+    if (!(c & bit_SSSE3) || !(c & bit_SSE4_1))
+        return 0;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+        return 0;
+    return (b & bit_SHA) != 0;
+}
+
+// 檢查 CPU 及操作系統是否支持 AVX-512F（含 ZMM 狀態保存）
+static int cpu_has_avx512(void)
+{
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d))
+        return 0;
+    if (!(c & bit_OSXSAVE))
+        return 0;
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 0xe6) != 0xe6)
+        return 0;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+        return 0;
+    return (b & bit_AVX512F) != 0;
+}
+
+/*
+ * 多緩衝區壓縮函數：轉置佈局，w[i] 的第 l 個通道是第 l 條消息的第 i 個字。
+ * 消息擴展使用 16 個字的環形緩衝區。
+ */
+#define MB_ROUNDS(V, ADD, SET1, SIG0V, SIG1V, EP0V, EP1V, CHV, MAJV) do {        \
+        V a = st[0], b = st[1], c = st[2], d = st[3];                            \
+        V e = st[4], f = st[5], g = st[6], h = st[7];                            \
+        for (int i = 0; i < 64; ++i) {                                           \
+            V wi;                                                                \
+            if (i < 16) {                                                        \
+                wi = w[i];                                                       \
+            } else {                                                             \
+                wi = ADD(ADD(SIG1V(w[(i - 2) & 15]), w[(i - 7) & 15]),           \
+                         ADD(SIG0V(w[(i - 15) & 15]), w[i & 15]));               \
+                w[i & 15] = wi;                                                  \
+            }                                                                    \
+            V t1 = ADD(ADD(ADD(h, EP1V(e)), ADD(CHV(e, f, g), SET1((int)k[i]))), wi); \
+            V t2 = ADD(EP0V(a), MAJV(a, b, c));                                  \
+            h = g;                                                               \
+            g = f;                                                               \
+            f = e;                                                               \
+            e = ADD(d, t1);                                                      \
+            d = c;                                                               \
+            c = b;                                                               \
+            b = a;                                                               \
+            a = ADD(t1, t2);                                                     \
+        }                                                                        \
+        st[0] = ADD(st[0], a); st[1] = ADD(st[1], b);                            \
+        st[2] = ADD(st[2], c); st[3] = ADD(st[3], d);                            \
+        st[4] = ADD(st[4], e); st[5] = ADD(st[5], f);                            \
+        st[6] = ADD(st[6], g); st[7] = ADD(st[7], h);                            \
+    } while (0)
+
+// AVX2：8 個通道
+#define ROR8(x, n)   _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+#define XOR8(x, y)   _mm256_xor_si256((x), (y))
+#define SIG0_8(x)    XOR8(XOR8(ROR8(x, 7), ROR8(x, 18)), _mm256_srli_epi32(x, 3))
+#define SIG1_8(x)    XOR8(XOR8(ROR8(x, 17), ROR8(x, 19)), _mm256_srli_epi32(x, 10))
+#define EP0_8(x)     XOR8(XOR8(ROR8(x, 2), ROR8(x, 13)), ROR8(x, 22))
+#define EP1_8(x)     XOR8(XOR8(ROR8(x, 6), ROR8(x, 11)), ROR8(x, 25))
+#define CH8(x, y, z) XOR8(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z))
+#define MAJ8(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+
+__attribute__((target("avx2")))
+static void sha256_compress_x8(__m256i st[8], __m256i w[16])
+{
+    MB_ROUNDS(__m256i, _mm256_add_epi32, _mm256_set1_epi32, SIG0_8, SIG1_8, EP0_8, EP1_8, CH8, MAJ8);
+}
+
+// wt/digest 為 [字][通道] 佈局，每行 stride 個通道，本函數處理從 lane0 開始的 8 個通道
+__attribute__((target("avx2")))
+static void sha256d_block_x8(const uint32_t *wt, uint32_t *digest, size_t stride)
+{
+    __m256i st[8], w[16];
+    for (int i = 0; i < 8; ++i)
+        st[i] = _mm256_set1_epi32((int)sha256_h0[i]);
+    for (int i = 0; i < 16; ++i)
+        w[i] = _mm256_loadu_si256((const __m256i *)(wt + i * stride));
+    sha256_compress_x8(st, w);
+
+    // 第二次哈希：32 字節摘要 + 固定的填充與長度
+    for (int i = 0; i < 8; ++i) {
+        w[i] = st[i];
+        st[i] = _mm256_set1_epi32((int)sha256_h0[i]);
+    }
+    w[8] = _mm256_set1_epi32((int)0x80000000);
+    for (int i = 9; i < 15; ++i)
+        w[i] = _mm256_setzero_si256();
+    w[15] = _mm256_set1_epi32(256);
+    sha256_compress_x8(st, w);
+
+    for (int i = 0; i < 8; ++i)
+        _mm256_storeu_si256((__m256i *)(digest + i * stride), st[i]);
+}
+
+// AVX-512：16 個通道，使用原生旋轉指令和三元邏輯指令
+#define ROR16(x, n)   _mm512_ror_epi32((x), (n))
+#define XOR3_16(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0x96)
+#define SIG0_16(x)    XOR3_16(ROR16(x, 7), ROR16(x, 18), _mm512_srli_epi32(x, 3))
+#define SIG1_16(x)    XOR3_16(ROR16(x, 17), ROR16(x, 19), _mm512_srli_epi32(x, 10))
+#define EP0_16(x)     XOR3_16(ROR16(x, 2), ROR16(x, 13), ROR16(x, 22))
+#define EP1_16(x)     XOR3_16(ROR16(x, 6), ROR16(x, 11), ROR16(x, 25))
+#define CH16(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0xCA)
+#define MAJ16(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0xE8)
+
+__attribute__((target("avx512f")))
+static void sha256_compress_x16(__m512i st[8], __m512i w[16])
+{
+    MB_ROUNDS(__m512i, _mm512_add_epi32, _mm512_set1_epi32, SIG0_16, SIG1_16, EP0_16, EP1_16, CH16, MAJ16);
+}
+
+__attribute__((target("avx512f")))
+static void sha256d_block_x16(const uint32_t *wt, uint32_t *digest, size_t stride)
+{
+    __m512i st[8], w[16];
+    for (int i = 0; i < 8; ++i)
+        st[i] = _mm512_set1_epi32((int)sha256_h0[i]);
+    for (int i = 0; i < 16; ++i)
+        w[i] = _mm512_loadu_si512((const void *)(wt + i * stride));
+    sha256_compress_x16(st, w);
+
+    for (int i = 0; i < 8; ++i) {
+        w[i] = st[i];
+        st[i] = _mm512_set1_epi32((int)sha256_h0[i]);
+    }
+    w[8] = _mm512_set1_epi32((int)0x80000000);
+    for (int i = 9; i < 15; ++i)
+        w[i] = _mm512_setzero_si512();
+    w[15] = _mm512_set1_epi32(256);
+    sha256_compress_x16(st, w);
+
+    for (int i = 0; i < 8; ++i)
+        _mm512_storeu_si512((void *)(digest + i * stride), st[i]);
+}
+#endif
+
+static sha256_transform_fn sha256_transform_impl = sha256_transform_scalar;
+static const char *sha256_impl = "scalar";
+
+int sha256_set_impl(const char *name)
+{
+    if (strcmp(name, "scalar") == 0) {
+        sha256_transform_impl = sha256_transform_scalar;
+        sha256_impl = "scalar";
+        return 1;
+    }
+#ifdef SHA256_X86_DISPATCH
+    if (strcmp(name, "avx2") == 0 && cpu_has_avx2()) {
+        sha256_transform_impl = sha256_transform_avx2;
+        sha256_impl = "avx2";
+        return 1;
+    }
+    if (strcmp(name, "shani") == 0 && cpu_has_shani()) {
+        sha256_transform_impl = sha256_transform_shani;
+        sha256_impl = "shani";
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+const char *sha256_impl_name(void)
+{
+    return sha256_impl;
+}
+
+/* 多緩衝區 sha256d 的實現：lanes 為每次並行處理的消息數，為 1 時逐條調用 sha256_transform_impl */
+typedef void (*sha256d_block_fn)(const uint32_t *wt, uint32_t *digest, size_t stride);
+static sha256d_block_fn sha256d_block_impl = NULL;
+static size_t sha256d_lanes = 1;
+static const char *sha256d_impl = "single";
+
+int sha256d_set_batch_impl(const char *name)
+{
+    if (strcmp(name, "single") == 0) {
+        sha256d_block_impl = NULL;
+        sha256d_lanes = 1;
+        sha256d_impl = "single";
+        return 1;
+    }
+#ifdef SHA256_X86_DISPATCH
+    if (strcmp(name, "avx2") == 0 && cpu_has_avx2()) {
+        sha256d_block_impl = sha256d_block_x8;
+        sha256d_lanes = 8;
+        sha256d_impl = "avx2";
+        return 1;
+    }
+    if (strcmp(name, "avx512") == 0 && cpu_has_avx512()) {
+        sha256d_block_impl = sha256d_block_x16;
+        sha256d_lanes = 16;
+        sha256d_impl = "avx512";
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+const char *sha256d_batch_impl_name(void)
+{
+    return sha256d_impl;
+}
+
+// 啟動時選擇最快的可用實現
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void sha256_select_impl(void)
+{
+    if (!sha256_set_impl("shani") && !sha256_set_impl("avx2"))
+        sha256_set_impl("scalar");
+    // 有 SHA-NI 時單條計算已足夠快，AVX2 的 8 通道版本並不更快；AVX-512 的 16 通道版本則更快
+    if (!sha256d_set_batch_impl("avx512") &&
+        (strcmp(sha256_impl, "shani") == 0 || !sha256d_set_batch_impl("avx2")))
+        sha256d_set_batch_impl("single");
+}
+
+// 沒有 constructor 屬性的編譯器在第一次使用時選擇
+static void sha256_lazy_select(void)
+{
+#if !defined(__GNUC__)
+    static int selected = 0;
+    if (!selected) {
+        sha256_select_impl();
+        selected = 1;
+    }
+#endif
 }
 
 void sha256_init(SHA256_CTX *ctx)
 {
+    sha256_lazy_select();
     ctx->datalen = 0;
     ctx->bitlen = 0;
     // 初始化初始向量（大端順序）
@@ -101,31 +519,48 @@ void sha256_init(SHA256_CTX *ctx)
 
 void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len)
 {
-    size_t i;
-    for (i = 0; i < len; ++i) {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
-        if (ctx->datalen == 64) {
-            sha256_transform(ctx, ctx->data);
-            ctx->bitlen += 512;
-            ctx->datalen = 0;
-        }
+    // 先補滿緩衝區中未完成的塊
+    if (ctx->datalen > 0) {
+        size_t n = 64 - ctx->datalen;
+        if (n > len)
+            n = len;
+        memcpy(ctx->data + ctx->datalen, data, n);
+        ctx->datalen += (uint32_t)n;
+        data += n;
+        len -= n;
+        if (ctx->datalen < 64)
+            return;
+        sha256_transform_impl(ctx->state, ctx->data, 1);
+        ctx->bitlen += 512;
+        ctx->datalen = 0;
+    }
+
+    // 完整的塊直接從輸入處理，不經過緩衝區
+    size_t blocks = len / 64;
+    if (blocks > 0) {
+        sha256_transform_impl(ctx->state, data, blocks);
+        ctx->bitlen += (uint64_t)blocks * 512;
+        data += blocks * 64;
+        len -= blocks * 64;
     }
+
+    memcpy(ctx->data, data, len);
+    ctx->datalen = (uint32_t)len;
 }
 
 void sha256_final(SHA256_CTX *ctx, uint8_t hash[])
 {
     size_t i = ctx->datalen;
 
-    // 添加填充數據：先填充 0x80
+    // 添加填充數據：先填充 0x80；剩餘空間放得下 8 字節長度（datalen <= 55）時只需一個塊
     ctx->data[i++] = 0x80;
-    if (i < 56) {
+    if (i <= 56) {
         while (i < 56)
             ctx->data[i++] = 0x00;
     } else {
         while (i < 64)
             ctx->data[i++] = 0x00;
-        sha256_transform(ctx, ctx->data);
+        sha256_transform_impl(ctx->state, ctx->data, 1);
         memset(ctx->data, 0, 56);
     }
 
@@ -139,7 +574,7 @@ void sha256_final(SHA256_CTX *ctx, uint8_t hash[])
     ctx->data[61] = (ctx->bitlen >> 16) & 0xff;
     ctx->data[62] = (ctx->bitlen >> 8) & 0xff;
     ctx->data[63] = (ctx->bitlen) & 0xff;
-    sha256_transform(ctx, ctx->data);
+    sha256_transform_impl(ctx->state, ctx->data, 1);
 
     // 將 state 轉換為最終的哈希值（大端輸出）
     for (i = 0; i < 4; ++i) {
@@ -162,3 +597,189 @@ void sha256(const uint8_t *data, size_t len, uint8_t *hash) {
 }
 
 
+
+/*
+ * 把不超過 55 字節的消息填充為一個完整的塊：0x80、補零，最後 8 字節為大端位長度
+ */
+static void sha256_pad_block(const uint8_t *msg, size_t len, uint8_t block[64])
+{
+    memcpy(block, msg, len);
+    block[len] = 0x80;
+    memset(block + len + 1, 0, 64 - len - 1);
+    uint64_t bitlen = (uint64_t)len * 8;
+    for (int i = 0; i < 8; ++i)
+        block[63 - i] = (uint8_t)(bitlen >> (8 * i));
+}
+
+/*
+ * 把不超過 55 字節的消息填充為一個塊，按大端轉換為 16 個字
+ */
+static void sha256_pad_short(const uint8_t *msg, size_t len, uint32_t w[16])
+{
+    uint8_t block[64];
+    sha256_pad_block(msg, len, block);
+    for (int i = 0; i < 16; ++i)
+        w[i] = ((uint32_t)block[4*i] << 24) | ((uint32_t)block[4*i+1] << 16) |
+               ((uint32_t)block[4*i+2] << 8) | block[4*i+3];
+}
+
+static void sha256_store_be(const uint32_t state[8], uint8_t hash[32])
+{
+    for (int i = 0; i < 8; ++i) {
+        hash[4*i]     = (uint8_t)(state[i] >> 24);
+        hash[4*i + 1] = (uint8_t)(state[i] >> 16);
+        hash[4*i + 2] = (uint8_t)(state[i] >> 8);
+        hash[4*i + 3] = (uint8_t)(state[i]);
+    }
+}
+
+/*
+ * 雙 SHA-256 的第二個塊固定為 32 字節摘要 + 填充：字 8 為 0x80000000，字 15 為位長度 256，
+ * 其餘為 0。這些常量在消息擴展中的貢獻可以預先算好。
+ */
+#define SHA256D_W8  0x80000000u
+#define SHA256D_W15 0x00000100u
+
+static const uint8_t sha256d_second_pad[32] = {
+    0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00
+};
+
+// 標量實現的第二個塊：w 為第一次哈希的 8 個狀態字（即第二個塊的字 0..7），結果寫入 state
+static void sha256d_second_scalar(const uint32_t w[8], uint32_t state[8])
+{
+    uint32_t m[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2;
+    int i;
+
+    for (i = 0; i < 8; ++i)
+        m[i] = w[i];
+    m[8] = SHA256D_W8;
+    m[9] = m[10] = m[11] = m[12] = m[13] = m[14] = 0;
+    m[15] = SHA256D_W15;
+
+    // 字 16..31 中來自常量字 8..15 的項已合併為常量，為 0 的項直接省略
+    m[16] = SIG0(m[1]) + m[0];
+    m[17] = SIG1(SHA256D_W15) + SIG0(m[2]) + m[1];
+    m[18] = SIG1(m[16]) + SIG0(m[3]) + m[2];
+    m[19] = SIG1(m[17]) + SIG0(m[4]) + m[3];
+    m[20] = SIG1(m[18]) + SIG0(m[5]) + m[4];
+    m[21] = SIG1(m[19]) + SIG0(m[6]) + m[5];
+    m[22] = SIG1(m[20]) + SHA256D_W15 + SIG0(m[7]) + m[6];
+    m[23] = SIG1(m[21]) + m[16] + SIG0(SHA256D_W8) + m[7];
+    m[24] = SIG1(m[22]) + m[17] + SHA256D_W8;
+    m[25] = SIG1(m[23]) + m[18];
+    m[26] = SIG1(m[24]) + m[19];
+    m[27] = SIG1(m[25]) + m[20];
+    m[28] = SIG1(m[26]) + m[21];
+    m[29] = SIG1(m[27]) + m[22];
+    m[30] = SIG1(m[28]) + m[23] + SIG0(SHA256D_W15);
+    m[31] = SIG1(m[29]) + m[24] + SIG0(m[16]) + SHA256D_W15;
+    for (i = 32; i < 64; ++i)
+        m[i] = SIG1(m[i-2]) + m[i-7] + SIG0(m[i-15]) + m[i-16];
+
+    a = sha256_h0[0];
+    b = sha256_h0[1];
+    c = sha256_h0[2];
+    d = sha256_h0[3];
+    e = sha256_h0[4];
+    f = sha256_h0[5];
+    g = sha256_h0[6];
+    h = sha256_h0[7];
+
+    for (i = 0; i < 64; ++i) {
+        t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
+        t2 = EP0(a) + MAJ(a,b,c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] = sha256_h0[0] + a;
+    state[1] = sha256_h0[1] + b;
+    state[2] = sha256_h0[2] + c;
+    state[3] = sha256_h0[3] + d;
+    state[4] = sha256_h0[4] + e;
+    state[5] = sha256_h0[5] + f;
+    state[6] = sha256_h0[6] + g;
+    state[7] = sha256_h0[7] + h;
+}
+
+void sha256d_short(const uint8_t *msg, size_t len, uint8_t hash[SHA256_BLOCK_SIZE])
+{
+    uint8_t block[64];
+    uint32_t state[8];
+
+    if (len > SHA256D_SHORT_MAX) {
+        uint8_t hash1[SHA256_BLOCK_SIZE];
+        sha256(msg, len, hash1);
+        sha256(hash1, SHA256_BLOCK_SIZE, hash);
+        return;
+    }
+    sha256_lazy_select();
+
+    // 第一次哈希：直接構造唯一的填充塊，不經過 SHA256_CTX 的緩衝與 final 填充
+    sha256_pad_block(msg, len, block);
+    memcpy(state, sha256_h0, sizeof(state));
+    sha256_transform_impl(state, block, 1);
+
+    if (sha256_transform_impl == sha256_transform_scalar) {
+        uint32_t w[8];
+        memcpy(w, state, sizeof(w));
+        sha256d_second_scalar(w, state);
+    } else {
+        // 硬件實現按字節塊輸入：摘要寫入前 32 字節，後 32 字節為固定填充
+        sha256_store_be(state, block);
+        memcpy(block + 32, sha256d_second_pad, sizeof(sha256d_second_pad));
+        memcpy(state, sha256_h0, sizeof(state));
+        sha256_transform_impl(state, block, 1);
+    }
+    sha256_store_be(state, hash);
+}
+
+#define SHA256D_BATCH_MAX 16
+
+void sha256d_short_batch(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t out[][32])
+{
+    for (size_t base = 0; base < n; base += SHA256D_BATCH_MAX) {
+        size_t count = n - base < SHA256D_BATCH_MAX ? n - base : SHA256D_BATCH_MAX;
+
+        if (!sha256d_block_impl) {
+            for (size_t l = 0; l < count; ++l)
+                sha256d_short(msgs[base + l], lens[base + l], out[base + l]);
+            continue;
+        }
+
+        // 轉置：wt[i][l] 是第 l 條消息的第 i 個字；超長消息單獨計算，其通道留空
+        uint32_t wt[16][SHA256D_BATCH_MAX];
+        uint32_t digest[8][SHA256D_BATCH_MAX];
+        memset(wt, 0, sizeof(wt));
+        for (size_t l = 0; l < count; ++l) {
+            if (lens[base + l] > SHA256D_SHORT_MAX)
+                continue;
+            uint32_t w[16];
+            sha256_pad_short(msgs[base + l], lens[base + l], w);
+            for (int i = 0; i < 16; ++i)
+                wt[i][l] = w[i];
+        }
+        for (size_t lane0 = 0; lane0 < count; lane0 += sha256d_lanes)
+            sha256d_block_impl(&wt[0][lane0], &digest[0][lane0], SHA256D_BATCH_MAX);
+
+        for (size_t l = 0; l < count; ++l) {
+            if (lens[base + l] > SHA256D_SHORT_MAX) {
+                sha256d_short(msgs[base + l], lens[base + l], out[base + l]);
+                continue;
+            }
+            uint32_t state[8];
+            for (int i = 0; i < 8; ++i)
+                state[i] = digest[i][l];
+            sha256_store_be(state, out[base + l]);
+        }
+    }
+}
@@ -28,6 +28,27 @@ void sha256_final(SHA256_CTX *ctx, uint8_t hash[]);
 // 一次性計算整個數據的 sha256 哈希值
 void sha256(const uint8_t *data, size_t len, uint8_t *hash);
 
+// 壓縮函數在程序啟動時按 CPUID 自動選擇（SHA-NI > AVX2 > 標量），以下接口用於查詢或強制指定實現
+// name: "shani"、"avx2" 或 "scalar"；CPU 不支持時返回 0 並保持原實現
+int sha256_set_impl(const char *name);
+// 返回當前使用的實現名稱
+const char *sha256_impl_name(void);
+
+// 填充後只佔一個塊的最長消息，適用於下面的雙 SHA-256 快速路徑
+#define SHA256D_SHORT_MAX 55
+
+// 計算 hash = SHA256(SHA256(msg))，用於 Base58Check 等短 payload 的校驗和。
+// 不超過 SHA256D_SHORT_MAX 字節時直接構造填充塊，第二個塊使用預先算好的常量；更長的消息退回通用路徑。
+void sha256d_short(const uint8_t *msg, size_t len, uint8_t hash[SHA256_BLOCK_SIZE]);
+
+// 批量計算 out[i] = SHA256(SHA256(msgs[i]))。不超過 SHA256D_SHORT_MAX 字節的消息按轉置佈局
+// 每 16（AVX-512）或 8（AVX2）條並行計算，更長的消息逐條計算。
+void sha256d_short_batch(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t out[][32]);
+// 強制指定批量實現："avx512"、"avx2" 或 "single"（逐條計算）；CPU 不支持時返回 0
+int sha256d_set_batch_impl(const char *name);
+// 返回當前批量實現的名稱
+const char *sha256d_batch_impl_name(void);
+
 #ifdef __cplusplus
 }
 #endif
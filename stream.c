@@ -0,0 +1,328 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// 流水線共享狀態，所有隊列都由 lock 保護
+typedef struct {
+    const StreamConfig *cfg;
+    FILE *fp;
+    pthread_mutex_t lock;
+    pthread_cond_t cond_free;    // 讀取線程等待空閒塊
+    pthread_cond_t cond_ready;   // 處理線程等待待處理塊
+    pthread_cond_t cond_done;    // 寫出線程等待下一個序號的塊
+    StreamChunk **all;           // 已分配的全部塊，用於最終釋放
+    int allocated;
+    StreamChunk *free_list;
+    StreamChunk *ready_head;
+    StreamChunk *ready_tail;
+    StreamChunk *done_list;      // 已處理、等待按序寫出的塊（重排序緩衝區）
+    size_t total_chunks;
+    int reader_done;
+    int failed;
+    int next_worker;             // 處理線程啟動時原子領取的編號
+} StreamState;
+
+static void stream_fail(StreamState *st) {
+    pthread_mutex_lock(&st->lock);
+    st->failed = 1;
+    pthread_cond_broadcast(&st->cond_free);
+    pthread_cond_broadcast(&st->cond_ready);
+    pthread_cond_broadcast(&st->cond_done);
+    pthread_mutex_unlock(&st->lock);
+}
+
+/*
+ * 取得一個空閒塊：優先復用，未達預算時新分配，否則等待寫出線程歸還
+ */
+static StreamChunk *acquire_chunk(StreamState *st) {
+    StreamChunk *chunk = NULL;
+    pthread_mutex_lock(&st->lock);
+    while (!st->failed && !st->free_list && st->allocated >= st->cfg->max_chunks)
+        pthread_cond_wait(&st->cond_free, &st->lock);
+    if (!st->failed) {
+        if (st->free_list) {
+            chunk = st->free_list;
+            st->free_list = chunk->next;
+        } else {
+            chunk = (StreamChunk *)calloc(1, sizeof(StreamChunk));
+            if (chunk) {
+                chunk->capacity = st->cfg->chunk_size;
+                chunk->data = (char *)malloc(chunk->capacity);
+                if (!chunk->data) {
+                    free(chunk);
+                    chunk = NULL;
+                } else {
+                    st->all[st->allocated++] = chunk;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&st->lock);
+    return chunk;
+}
+
+static void release_chunk(StreamState *st, StreamChunk *chunk) {
+    pthread_mutex_lock(&st->lock);
+    chunk->next = st->free_list;
+    st->free_list = chunk;
+    pthread_cond_signal(&st->cond_free);
+    pthread_mutex_unlock(&st->lock);
+}
+
+static int grow_chunk(StreamChunk *chunk, size_t need) {
+    if (chunk->capacity >= need)
+        return 1;
+    size_t capacity = chunk->capacity ? chunk->capacity : 4096;
+    while (capacity < need)
+        capacity *= 2;
+    char *temp = (char *)realloc(chunk->data, capacity);
+    if (!temp)
+        return 0;
+    chunk->data = temp;
+    chunk->capacity = capacity;
+    return 1;
+}
+
+/*
+ * 讀取線程：按塊讀取輸入，塊尾不完整的行留到下一塊
+ */
+static void *reader_thread(void *arg) {
+    StreamState *st = (StreamState *)arg;
+    char *carry = NULL;
+    size_t carry_len = 0, carry_capacity = 0;
+    size_t seq = 0;
+    int eof = 0;
+    int oom = 0;
+
+    // 已從 fp 讀走的開頭字節當作上一塊留下的不完整行，併入第一塊
+    if (st->cfg->prefix_len > 0) {
+        carry = (char *)malloc(st->cfg->prefix_len);
+        if (!carry) {
+            stream_fail(st);
+            eof = 1;
+        } else {
+            memcpy(carry, st->cfg->prefix, st->cfg->prefix_len);
+            carry_len = carry_capacity = st->cfg->prefix_len;
+        }
+    }
+
+    while (!eof) {
+        StreamChunk *chunk = acquire_chunk(st);
+        if (!chunk) {
+            stream_fail(st);
+            break;
+        }
+
+        if (!grow_chunk(chunk, carry_len * 2)) {
+            release_chunk(st, chunk);
+            stream_fail(st);
+            break;
+        }
+        memcpy(chunk->data, carry, carry_len);
+        chunk->size = carry_len;
+        carry_len = 0;
+
+        size_t split = 0;
+        for (;;) {
+            while (chunk->size < chunk->capacity) {
+                size_t n = fread(chunk->data + chunk->size, 1, chunk->capacity - chunk->size, st->fp);
+                if (n == 0) {
+                    eof = 1;
+                    break;
+                }
+                chunk->size += n;
+            }
+            if (eof)
+                break;
+
+            // 塊已滿：在最後一個換行符處切開；整塊都不含換行符時擴容繼續讀
+            size_t i = chunk->size;
+            while (i > 0 && chunk->data[i - 1] != '\n')
+                i--;
+            if (i > 0) {
+                split = i;
+                break;
+            }
+            if (!grow_chunk(chunk, chunk->capacity * 2)) {
+                oom = 1;
+                break;
+            }
+        }
+
+        if (oom || (eof && ferror(st->fp))) {
+            release_chunk(st, chunk);
+            stream_fail(st);
+            break;
+        }
+
+        if (!eof) {
+            carry_len = chunk->size - split;
+            if (carry_len > carry_capacity) {
+                char *temp = (char *)realloc(carry, carry_len);
+                if (!temp) {
+                    release_chunk(st, chunk);
+                    stream_fail(st);
+                    break;
+                }
+                carry = temp;
+                carry_capacity = carry_len;
+            }
+            memcpy(carry, chunk->data + split, carry_len);
+            chunk->size = split;
+        }
+
+        if (chunk->size == 0) {
+            release_chunk(st, chunk);
+            continue;
+        }
+
+        pthread_mutex_lock(&st->lock);
+        chunk->seq = seq++;
+        chunk->next = NULL;
+        if (st->ready_tail)
+            st->ready_tail->next = chunk;
+        else
+            st->ready_head = chunk;
+        st->ready_tail = chunk;
+        pthread_cond_signal(&st->cond_ready);
+        pthread_mutex_unlock(&st->lock);
+    }
+
+    free(carry);
+    pthread_mutex_lock(&st->lock);
+    st->reader_done = 1;
+    st->total_chunks = seq;
+    pthread_cond_broadcast(&st->cond_ready);
+    pthread_cond_broadcast(&st->cond_done);
+    pthread_mutex_unlock(&st->lock);
+    return NULL;
+}
+
+/*
+ * 處理線程：建立行索引並逐行處理，完成後放入重排序緩衝區
+ */
+static void *worker_thread(void *arg) {
+    StreamState *st = (StreamState *)arg;
+    const StreamConfig *cfg = st->cfg;
+
+    if (cfg->worker_init)
+        cfg->worker_init(__atomic_fetch_add(&st->next_worker, 1, __ATOMIC_RELAXED), cfg->ctx);
+
+    for (;;) {
+        pthread_mutex_lock(&st->lock);
+        while (!st->failed && !st->ready_head && !st->reader_done)
+            pthread_cond_wait(&st->cond_ready, &st->lock);
+        StreamChunk *chunk = st->failed ? NULL : st->ready_head;
+        if (chunk) {
+            st->ready_head = chunk->next;
+            if (!st->ready_head)
+                st->ready_tail = NULL;
+        }
+        pthread_mutex_unlock(&st->lock);
+        if (!chunk)
+            break;
+
+        if (input_index_range(chunk->data, chunk->size, &chunk->lines, &chunk->count, &chunk->lines_capacity) != 0) {
+            stream_fail(st);
+            break;
+        }
+        size_t need = chunk->count * cfg->result_size;
+        if (need > chunk->results_capacity) {
+            void *temp = realloc(chunk->results, need);
+            if (!temp) {
+                stream_fail(st);
+                break;
+            }
+            chunk->results = temp;
+            chunk->results_capacity = need;
+        }
+        cfg->process(chunk, cfg->ctx);
+
+        pthread_mutex_lock(&st->lock);
+        chunk->next = st->done_list;
+        st->done_list = chunk;
+        pthread_cond_broadcast(&st->cond_done);
+        pthread_mutex_unlock(&st->lock);
+    }
+    return NULL;
+}
+
+int stream_run(FILE *fp, const StreamConfig *cfg) {
+    StreamState st;
+    memset(&st, 0, sizeof(st));
+    st.cfg = cfg;
+    st.fp = fp;
+    st.all = (StreamChunk **)calloc((size_t)cfg->max_chunks, sizeof(StreamChunk *));
+    if (!st.all)
+        return -1;
+    pthread_mutex_init(&st.lock, NULL);
+    pthread_cond_init(&st.cond_free, NULL);
+    pthread_cond_init(&st.cond_ready, NULL);
+    pthread_cond_init(&st.cond_done, NULL);
+
+    pthread_t reader;
+    pthread_t *workers = (pthread_t *)malloc((size_t)cfg->worker_count * sizeof(pthread_t));
+    int started = 0;
+    int reader_started = 0;
+    if (workers && pthread_create(&reader, NULL, reader_thread, &st) == 0) {
+        reader_started = 1;
+        for (; started < cfg->worker_count; started++) {
+            if (pthread_create(&workers[started], NULL, worker_thread, &st) != 0)
+                break;
+        }
+    }
+    if (!reader_started || started == 0)
+        stream_fail(&st);
+
+    // 寫出：按序號從重排序緩衝區取塊，保證輸出順序與輸入一致
+    size_t next_seq = 0;
+    for (;;) {
+        pthread_mutex_lock(&st.lock);
+        StreamChunk *chunk = NULL;
+        for (;;) {
+            StreamChunk **pp = &st.done_list;
+            while (*pp && (*pp)->seq != next_seq)
+                pp = &(*pp)->next;
+            if (*pp) {
+                chunk = *pp;
+                *pp = chunk->next;
+                break;
+            }
+            if (st.failed || (st.reader_done && next_seq == st.total_chunks))
+                break;
+            pthread_cond_wait(&st.cond_done, &st.lock);
+        }
+        pthread_mutex_unlock(&st.lock);
+        if (!chunk)
+            break;
+
+        if (cfg->emit(chunk, cfg->ctx) != 0)
+            stream_fail(&st);
+        release_chunk(&st, chunk);
+        next_seq++;
+    }
+
+    if (reader_started)
+        pthread_join(reader, NULL);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+
+    int ret = st.failed ? -1 : 0;
+    for (int i = 0; i < st.allocated; i++) {
+        free(st.all[i]->data);
+        free(st.all[i]->lines);
+        free(st.all[i]->results);
+        free(st.all[i]);
+    }
+    free(st.all);
+    free(workers);
+    pthread_mutex_destroy(&st.lock);
+    pthread_cond_destroy(&st.cond_free);
+    pthread_cond_destroy(&st.cond_ready);
+    pthread_cond_destroy(&st.cond_done);
+    return ret;
+}
@@ -0,0 +1,53 @@
+/*Author: 8891689
+ *https://github.com/8891689
+ */
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 流水線中的一個數據塊：若干完整的行及其逐行處理結果
+typedef struct StreamChunk {
+    size_t seq;              // 塊在輸入中的序號，寫出線程按序號還原輸入順序
+    char *data;              // 塊內容（只包含完整的行）
+    size_t size;
+    size_t capacity;
+    LineView *lines;         // 塊內的行視圖，由工作線程建立
+    size_t count;
+    size_t lines_capacity;
+    void *results;           // count 個結果，每個 result_size 字節
+    size_t results_capacity;
+    struct StreamChunk *next;
+} StreamChunk;
+
+// 流水線配置：讀取線程 → worker_count 個處理線程 → 調用 stream_run 的線程按順序寫出
+typedef struct {
+    size_t chunk_size;       // 每塊讀取的字節數（單行超長時該塊會自動擴容）
+    int max_chunks;          // 同時在內存中的塊數上限，決定流水線的內存預算
+    int worker_count;        // 處理線程數
+    const void *prefix;      // 已從 fp 讀走、應放在輸入開頭的字節，沒有時為 NULL
+    size_t prefix_len;
+    size_t result_size;      // 每行結果佔用的字節數
+    // 處理線程中調用：chunk->lines 已建立，填充 chunk->results
+    void (*process)(StreamChunk *chunk, void *ctx);
+    // 寫出線程中按 seq 順序調用
+    int (*emit)(StreamChunk *chunk, void *ctx);
+    // 可為 NULL；每個處理線程開始時調用一次，index 為 0..worker_count-1
+    void (*worker_init)(int index, void *ctx);
+    void *ctx;
+} StreamConfig;
+
+// 運行流水線直到 fp 讀完。返回 0 表示成功，-1 表示讀取錯誤、內存不足或 emit 失敗。
+int stream_run(FILE *fp, const StreamConfig *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STREAM_H